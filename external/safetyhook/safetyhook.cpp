@@ -525,12 +525,12 @@ static bool decode(ZydisDecodedInstruction* ix, uint8_t* ip) {
     return ZYAN_SUCCESS(ZydisDecoderDecodeInstruction(&decoder, nullptr, ip, 15, ix));
 }
 
-std::expected<InlineHook, InlineHook::Error> InlineHook::create(void* target, void* destination) {
-    return create(Allocator::global(), target, destination);
+std::expected<InlineHook, InlineHook::Error> InlineHook::create(void* target, void* destination, Flags flags) {
+    return create(Allocator::global(), target, destination, flags);
 }
 
 std::expected<InlineHook, InlineHook::Error> InlineHook::create(
-    const std::shared_ptr<Allocator>& allocator, void* target, void* destination) {
+    const std::shared_ptr<Allocator>& allocator, void* target, void* destination, Flags flags) {
     InlineHook hook{};
 
     if (const auto setup_result =
@@ -539,6 +539,12 @@ std::expected<InlineHook, InlineHook::Error> InlineHook::create(
         return std::unexpected{setup_result.error()};
     }
 
+    if (!(flags & StartDisabled)) {
+        if (auto enable_result = hook.enable(); !enable_result) {
+            return std::unexpected{enable_result.error()};
+        }
+    }
+
     return hook;
 }
 
@@ -557,10 +563,14 @@ InlineHook& InlineHook::operator=(InlineHook&& other) noexcept {
         m_trampoline = std::move(other.m_trampoline);
         m_trampoline_size = other.m_trampoline_size;
         m_original_bytes = std::move(other.m_original_bytes);
+        m_type = other.m_type;
+        m_enabled = other.m_enabled;
 
         other.m_target = nullptr;
         other.m_destination = nullptr;
         other.m_trampoline_size = 0;
+        other.m_type = Type::Unset;
+        other.m_enabled = false;
     }
 
     return *this;
@@ -716,26 +726,8 @@ std::expected<void, InlineHook::Error> InlineHook::e9_hook(const std::shared_ptr
     }
 #endif
 
-    std::optional<Error> error;
-
-    // jmp from original to trampoline.
-    execute_while_frozen(
-        [this, &trampoline_epilogue, &error] {
-            if (auto result = emit_jmp_e9(m_target,
-                    reinterpret_cast<uint8_t*>(&trampoline_epilogue->jmp_to_destination), m_original_bytes.size());
-                !result) {
-                error = result.error();
-            }
-        },
-        [this](auto, auto, auto ctx) {
-            for (size_t i = 0; i < m_original_bytes.size(); ++i) {
-                fix_ip(ctx, m_target + i, m_trampoline.data() + i);
-            }
-        });
-
-    if (error) {
-        return std::unexpected{*error};
-    }
+    // jmp from original to trampoline is written by enable().
+    m_type = Type::E9;
 
     return {};
 }
@@ -784,13 +776,60 @@ std::expected<void, InlineHook::Error> InlineHook::ff_hook(const std::shared_ptr
         return std::unexpected{result.error()};
     }
 
+    // jmp from original to destination is written by enable().
+    m_type = Type::FF;
+
+    return {};
+}
+#endif
+
+std::expected<void, InlineHook::Error> InlineHook::patch() {
+#if SAFETYHOOK_ARCH_X86_64
+    if (m_type == Type::FF) {
+        if (auto result = emit_jmp_ff(m_target, m_destination, m_target + sizeof(JmpFF), m_original_bytes.size());
+            !result) {
+            return std::unexpected{result.error()};
+        }
+
+        m_enabled = true;
+        return {};
+    }
+#endif
+
+    auto trampoline_epilogue = reinterpret_cast<TrampolineEpilogueE9*>(
+        m_trampoline.address() + m_trampoline_size - sizeof(TrampolineEpilogueE9));
+
+    if (auto result = emit_jmp_e9(
+            m_target, reinterpret_cast<uint8_t*>(&trampoline_epilogue->jmp_to_destination), m_original_bytes.size());
+        !result) {
+        return std::unexpected{result.error()};
+    }
+
+    m_enabled = true;
+    return {};
+}
+
+void InlineHook::unpatch() {
+    if (auto um = unprotect(m_target, m_original_bytes.size())) {
+        std::copy(m_original_bytes.begin(), m_original_bytes.end(), m_target);
+    }
+
+    m_enabled = false;
+}
+
+std::expected<void, InlineHook::Error> InlineHook::enable() {
+    std::scoped_lock lock{m_mutex};
+
+    if (m_enabled || !m_trampoline) {
+        return {};
+    }
+
     std::optional<Error> error;
 
     // jmp from original to trampoline.
     execute_while_frozen(
         [this, &error] {
-            if (auto result = emit_jmp_ff(m_target, m_destination, m_target + sizeof(JmpFF), m_original_bytes.size());
-                !result) {
+            if (auto result = patch(); !result) {
                 error = result.error();
             }
         },
@@ -806,27 +845,33 @@ std::expected<void, InlineHook::Error> InlineHook::ff_hook(const std::shared_ptr
 
     return {};
 }
-#endif
 
-void InlineHook::destroy() {
+std::expected<void, InlineHook::Error> InlineHook::disable() {
     std::scoped_lock lock{m_mutex};
 
-    if (!m_trampoline) {
-        return;
+    if (!m_enabled) {
+        return {};
     }
 
-    execute_while_frozen(
-        [this] {
-            if (auto um = unprotect(m_target, m_original_bytes.size())) {
-                std::copy(m_original_bytes.begin(), m_original_bytes.end(), m_target);
-            }
-        },
+    execute_while_frozen([this] { unpatch(); },
         [this](auto, auto, auto ctx) {
             for (size_t i = 0; i < m_original_bytes.size(); ++i) {
                 fix_ip(ctx, m_trampoline.data() + i, m_target + i);
             }
         });
 
+    return {};
+}
+
+void InlineHook::destroy() {
+    std::scoped_lock lock{m_mutex};
+
+    if (!m_trampoline) {
+        return;
+    }
+
+    (void)disable();
+
     m_trampoline.free();
 }
 } // namespace safetyhook
@@ -842,74 +887,17 @@ void InlineHook::destroy() {
 
 namespace safetyhook {
 
-#if SAFETYHOOK_ARCH_X86_64
-#if SAFETYHOOK_OS_WINDOWS
-constexpr std::array<uint8_t, 391> asm_data = {0xFF, 0x35, 0x79, 0x01, 0x00, 0x00, 0x54, 0x54, 0x55, 0x50, 0x53, 0x51,
-    0x52, 0x56, 0x57, 0x41, 0x50, 0x41, 0x51, 0x41, 0x52, 0x41, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57,
-    0x9C, 0x48, 0x81, 0xEC, 0x00, 0x01, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0xBC, 0x24, 0xF0, 0x00, 0x00, 0x00, 0xF3,
-    0x44, 0x0F, 0x7F, 0xB4, 0x24, 0xE0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0xAC, 0x24, 0xD0, 0x00, 0x00, 0x00,
-    0xF3, 0x44, 0x0F, 0x7F, 0xA4, 0x24, 0xC0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x9C, 0x24, 0xB0, 0x00, 0x00,
-    0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x94, 0x24, 0xA0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x8C, 0x24, 0x90, 0x00,
-    0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x84, 0x24, 0x80, 0x00, 0x00, 0x00, 0xF3, 0x0F, 0x7F, 0x7C, 0x24, 0x70, 0xF3,
-    0x0F, 0x7F, 0x74, 0x24, 0x60, 0xF3, 0x0F, 0x7F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x7F, 0x64, 0x24, 0x40, 0xF3, 0x0F,
-    0x7F, 0x5C, 0x24, 0x30, 0xF3, 0x0F, 0x7F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x7F, 0x4C, 0x24, 0x10, 0xF3, 0x0F, 0x7F,
-    0x04, 0x24, 0x48, 0x8B, 0x8C, 0x24, 0x80, 0x01, 0x00, 0x00, 0x48, 0x83, 0xC1, 0x10, 0x48, 0x89, 0x8C, 0x24, 0x80,
-    0x01, 0x00, 0x00, 0x48, 0x8D, 0x0C, 0x24, 0x48, 0x89, 0xE3, 0x48, 0x83, 0xEC, 0x30, 0x48, 0x83, 0xE4, 0xF0, 0xFF,
-    0x15, 0xA8, 0x00, 0x00, 0x00, 0x48, 0x89, 0xDC, 0xF3, 0x0F, 0x6F, 0x04, 0x24, 0xF3, 0x0F, 0x6F, 0x4C, 0x24, 0x10,
-    0xF3, 0x0F, 0x6F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x6F, 0x5C, 0x24, 0x30, 0xF3, 0x0F, 0x6F, 0x64, 0x24, 0x40, 0xF3,
-    0x0F, 0x6F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x6F, 0x74, 0x24, 0x60, 0xF3, 0x0F, 0x6F, 0x7C, 0x24, 0x70, 0xF3, 0x44,
-    0x0F, 0x6F, 0x84, 0x24, 0x80, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0x8C, 0x24, 0x90, 0x00, 0x00, 0x00, 0xF3,
-    0x44, 0x0F, 0x6F, 0x94, 0x24, 0xA0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0x9C, 0x24, 0xB0, 0x00, 0x00, 0x00,
-    0xF3, 0x44, 0x0F, 0x6F, 0xA4, 0x24, 0xC0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xAC, 0x24, 0xD0, 0x00, 0x00,
-    0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xB4, 0x24, 0xE0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xBC, 0x24, 0xF0, 0x00,
-    0x00, 0x00, 0x48, 0x81, 0xC4, 0x00, 0x01, 0x00, 0x00, 0x9D, 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x41,
-    0x5B, 0x41, 0x5A, 0x41, 0x59, 0x41, 0x58, 0x5F, 0x5E, 0x5A, 0x59, 0x5B, 0x58, 0x5D, 0x48, 0x8D, 0x64, 0x24, 0x08,
-    0x5C, 0xC3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-#elif SAFETYHOOK_OS_LINUX
-constexpr std::array<uint8_t, 391> asm_data = {0xFF, 0x35, 0x79, 0x01, 0x00, 0x00, 0x54, 0x54, 0x55, 0x50, 0x53, 0x51,
-    0x52, 0x56, 0x57, 0x41, 0x50, 0x41, 0x51, 0x41, 0x52, 0x41, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57,
-    0x9C, 0x48, 0x81, 0xEC, 0x00, 0x01, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0xBC, 0x24, 0xF0, 0x00, 0x00, 0x00, 0xF3,
-    0x44, 0x0F, 0x7F, 0xB4, 0x24, 0xE0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0xAC, 0x24, 0xD0, 0x00, 0x00, 0x00,
-    0xF3, 0x44, 0x0F, 0x7F, 0xA4, 0x24, 0xC0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x9C, 0x24, 0xB0, 0x00, 0x00,
-    0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x94, 0x24, 0xA0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x8C, 0x24, 0x90, 0x00,
-    0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x84, 0x24, 0x80, 0x00, 0x00, 0x00, 0xF3, 0x0F, 0x7F, 0x7C, 0x24, 0x70, 0xF3,
-    0x0F, 0x7F, 0x74, 0x24, 0x60, 0xF3, 0x0F, 0x7F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x7F, 0x64, 0x24, 0x40, 0xF3, 0x0F,
-    0x7F, 0x5C, 0x24, 0x30, 0xF3, 0x0F, 0x7F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x7F, 0x4C, 0x24, 0x10, 0xF3, 0x0F, 0x7F,
-    0x04, 0x24, 0x48, 0x8B, 0xBC, 0x24, 0x80, 0x01, 0x00, 0x00, 0x48, 0x83, 0xC7, 0x10, 0x48, 0x89, 0xBC, 0x24, 0x80,
-    0x01, 0x00, 0x00, 0x48, 0x8D, 0x3C, 0x24, 0x48, 0x89, 0xE3, 0x48, 0x83, 0xEC, 0x30, 0x48, 0x83, 0xE4, 0xF0, 0xFF,
-    0x15, 0xA8, 0x00, 0x00, 0x00, 0x48, 0x89, 0xDC, 0xF3, 0x0F, 0x6F, 0x04, 0x24, 0xF3, 0x0F, 0x6F, 0x4C, 0x24, 0x10,
-    0xF3, 0x0F, 0x6F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x6F, 0x5C, 0x24, 0x30, 0xF3, 0x0F, 0x6F, 0x64, 0x24, 0x40, 0xF3,
-    0x0F, 0x6F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x6F, 0x74, 0x24, 0x60, 0xF3, 0x0F, 0x6F, 0x7C, 0x24, 0x70, 0xF3, 0x44,
-    0x0F, 0x6F, 0x84, 0x24, 0x80, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0x8C, 0x24, 0x90, 0x00, 0x00, 0x00, 0xF3,
-    0x44, 0x0F, 0x6F, 0x94, 0x24, 0xA0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0x9C, 0x24, 0xB0, 0x00, 0x00, 0x00,
-    0xF3, 0x44, 0x0F, 0x6F, 0xA4, 0x24, 0xC0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xAC, 0x24, 0xD0, 0x00, 0x00,
-    0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xB4, 0x24, 0xE0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xBC, 0x24, 0xF0, 0x00,
-    0x00, 0x00, 0x48, 0x81, 0xC4, 0x00, 0x01, 0x00, 0x00, 0x9D, 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x41,
-    0x5B, 0x41, 0x5A, 0x41, 0x59, 0x41, 0x58, 0x5F, 0x5E, 0x5A, 0x59, 0x5B, 0x58, 0x5D, 0x48, 0x8D, 0x64, 0x24, 0x08,
-    0x5C, 0xC3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-#endif
-#elif SAFETYHOOK_ARCH_X86_32
-constexpr std::array<uint8_t, 171> asm_data = {0xFF, 0x35, 0xA7, 0x00, 0x00, 0x00, 0x54, 0x54, 0x55, 0x50, 0x53, 0x51,
-    0x52, 0x56, 0x57, 0x9C, 0x81, 0xEC, 0x80, 0x00, 0x00, 0x00, 0xF3, 0x0F, 0x7F, 0x7C, 0x24, 0x70, 0xF3, 0x0F, 0x7F,
-    0x74, 0x24, 0x60, 0xF3, 0x0F, 0x7F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x7F, 0x64, 0x24, 0x40, 0xF3, 0x0F, 0x7F, 0x5C,
-    0x24, 0x30, 0xF3, 0x0F, 0x7F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x7F, 0x4C, 0x24, 0x10, 0xF3, 0x0F, 0x7F, 0x04, 0x24,
-    0x8B, 0x8C, 0x24, 0xA0, 0x00, 0x00, 0x00, 0x83, 0xC1, 0x08, 0x89, 0x8C, 0x24, 0xA0, 0x00, 0x00, 0x00, 0x54, 0xFF,
-    0x15, 0xA3, 0x00, 0x00, 0x00, 0x83, 0xC4, 0x04, 0xF3, 0x0F, 0x6F, 0x04, 0x24, 0xF3, 0x0F, 0x6F, 0x4C, 0x24, 0x10,
-    0xF3, 0x0F, 0x6F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x6F, 0x5C, 0x24, 0x30, 0xF3, 0x0F, 0x6F, 0x64, 0x24, 0x40, 0xF3,
-    0x0F, 0x6F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x6F, 0x74, 0x24, 0x60, 0xF3, 0x0F, 0x6F, 0x7C, 0x24, 0x70, 0x81, 0xC4,
-    0x80, 0x00, 0x00, 0x00, 0x9D, 0x5F, 0x5E, 0x5A, 0x59, 0x5B, 0x58, 0x5D, 0x8D, 0x64, 0x24, 0x04, 0x5C, 0xC3, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-#endif
-
-std::expected<MidHook, MidHook::Error> MidHook::create(void* target, MidHookFn destination) {
-    return create(Allocator::global(), target, destination);
+std::expected<MidHook, MidHook::Error> MidHook::create(
+    void* target, MidHookFn destination, Flags flags, RegisterMask registers) {
+    return create(Allocator::global(), target, destination, flags, registers);
 }
 
-std::expected<MidHook, MidHook::Error> MidHook::create(
-    const std::shared_ptr<Allocator>& allocator, void* target, MidHookFn destination) {
+std::expected<MidHook, MidHook::Error> MidHook::create(const std::shared_ptr<Allocator>& allocator, void* target,
+    MidHookFn destination, Flags flags, RegisterMask registers) {
     MidHook hook{};
 
-    if (const auto setup_result = hook.setup(allocator, reinterpret_cast<uint8_t*>(target), destination);
+    if (const auto setup_result =
+            hook.setup(allocator, reinterpret_cast<uint8_t*>(target), destination, flags, registers);
         !setup_result) {
         return std::unexpected{setup_result.error()};
     }
@@ -939,12 +927,13 @@ void MidHook::reset() {
     *this = {};
 }
 
-std::expected<void, MidHook::Error> MidHook::setup(
-    const std::shared_ptr<Allocator>& allocator, uint8_t* target, MidHookFn destination_fn) {
+std::expected<void, MidHook::Error> MidHook::setup(const std::shared_ptr<Allocator>& allocator, uint8_t* target,
+    MidHookFn destination_fn, Flags flags, RegisterMask registers) {
     m_target = target;
     m_destination = destination_fn;
 
-    auto stub_allocation = allocator->allocate(asm_data.size());
+    const auto stub_code = detail::mid_hook_stub(registers);
+    auto stub_allocation = allocator->allocate(stub_code.size());
 
     if (!stub_allocation) {
         return std::unexpected{Error::bad_allocation(stub_allocation.error())};
@@ -952,19 +941,20 @@ std::expected<void, MidHook::Error> MidHook::setup(
 
     m_stub = std::move(*stub_allocation);
 
-    std::copy(asm_data.begin(), asm_data.end(), m_stub.data());
+    std::copy(stub_code.begin(), stub_code.end(), m_stub.data());
 
 #if SAFETYHOOK_ARCH_X86_64
-    store(m_stub.data() + sizeof(asm_data) - 16, m_destination);
+    store(m_stub.data() + stub_code.size() - 16, m_destination);
 #elif SAFETYHOOK_ARCH_X86_32
-    store(m_stub.data() + sizeof(asm_data) - 8, m_destination);
+    store(m_stub.data() + stub_code.size() - 8, m_destination);
 
     // 32-bit has some relocations we need to fix up as well.
     store(m_stub.data() + 0x02, m_stub.data() + m_stub.size() - 4);
     store(m_stub.data() + 0x59, m_stub.data() + m_stub.size() - 8);
 #endif
 
-    auto hook_result = InlineHook::create(allocator, m_target, m_stub.data());
+    // The hook starts disabled so the stub is complete before anything can jump into it.
+    auto hook_result = InlineHook::create(allocator, m_target, m_stub.data(), InlineHook::StartDisabled);
 
     if (!hook_result) {
         m_stub.free();
@@ -974,13 +964,125 @@ std::expected<void, MidHook::Error> MidHook::setup(
     m_hook = std::move(*hook_result);
 
 #if SAFETYHOOK_ARCH_X86_64
-    store(m_stub.data() + sizeof(asm_data) - 8, m_hook.trampoline().data());
+    store(m_stub.data() + stub_code.size() - 8, m_hook.trampoline().data());
 #elif SAFETYHOOK_ARCH_X86_32
-    store(m_stub.data() + sizeof(asm_data) - 4, m_hook.trampoline().data());
+    store(m_stub.data() + stub_code.size() - 4, m_hook.trampoline().data());
 #endif
 
+    if (!(flags & StartDisabled)) {
+        if (auto enable_result = m_hook.enable(); !enable_result) {
+            m_hook.reset();
+            m_stub.free();
+            return std::unexpected{Error::bad_inline_hook(enable_result.error())};
+        }
+    }
+
+    return {};
+}
+
+std::expected<void, MidHook::Error> MidHook::enable() {
+    if (auto enable_result = m_hook.enable(); !enable_result) {
+        return std::unexpected{Error::bad_inline_hook(enable_result.error())};
+    }
+
     return {};
 }
+
+std::expected<void, MidHook::Error> MidHook::disable() {
+    if (auto disable_result = m_hook.disable(); !disable_result) {
+        return std::unexpected{Error::bad_inline_hook(disable_result.error())};
+    }
+
+    return {};
+}
+
+std::expected<HookBatch::Result, InlineHook::Error> HookBatch::commit() {
+    std::vector<InlineHook*> enable;
+    std::vector<InlineHook*> disable;
+    std::vector<std::unique_lock<std::recursive_mutex>> locks;
+
+    for (auto hook : m_enable) {
+        locks.emplace_back(hook->m_mutex);
+
+        if (*hook && !hook->m_enabled && std::find(enable.begin(), enable.end(), hook) == enable.end()) {
+            enable.push_back(hook);
+        }
+    }
+
+    for (auto hook : m_disable) {
+        locks.emplace_back(hook->m_mutex);
+
+        if (hook->m_enabled && std::find(enable.begin(), enable.end(), hook) == enable.end() &&
+            std::find(disable.begin(), disable.end(), hook) == disable.end()) {
+            disable.push_back(hook);
+        }
+    }
+
+    auto writes = std::move(m_writes);
+    m_enable.clear();
+    m_disable.clear();
+    m_writes.clear();
+
+    if (enable.empty() && disable.empty() && writes.empty()) {
+        return Result{0, 0, 0, {}};
+    }
+
+    std::optional<InlineHook::Error> error;
+    const auto freeze_start = std::chrono::steady_clock::now();
+
+    size_t written = 0;
+    execute_while_frozen(
+        [&enable, &disable, &writes, &written, &error] {
+            for (auto hook : disable) {
+                hook->unpatch();
+            }
+
+            for (auto& [address, bytes] : writes) {
+                if (auto um = unprotect(address, bytes.size())) {
+                    std::copy(bytes.begin(), bytes.end(), address);
+                    ++written;
+                }
+            }
+
+            for (size_t i = 0; i < enable.size(); ++i) {
+                if (auto result = enable[i]->patch(); !result) {
+                    error = result.error();
+
+                    // Undo the hooks this batch already enabled. Disabled hooks stay disabled since threads
+                    // have already been moved out of their trampolines.
+                    for (size_t j = 0; j < i; ++j) {
+                        enable[j]->unpatch();
+                    }
+
+                    return;
+                }
+            }
+        },
+        [&enable, &disable](auto, auto, auto ctx) {
+            // A thread inside a target moves to the same instruction in the trampoline, which stays valid
+            // even if the batch is rolled back.
+            for (auto hook : enable) {
+                for (size_t i = 0; i < hook->m_original_bytes.size(); ++i) {
+                    fix_ip(ctx, hook->m_target + i, hook->m_trampoline.data() + i);
+                }
+            }
+
+            // A thread inside a trampoline that is being removed moves back to the target.
+            for (auto hook : disable) {
+                for (size_t i = 0; i < hook->m_original_bytes.size(); ++i) {
+                    fix_ip(ctx, hook->m_trampoline.data() + i, hook->m_target + i);
+                }
+            }
+        });
+
+    const auto frozen_for = std::chrono::steady_clock::now() - freeze_start;
+
+    if (error) {
+        return std::unexpected{*error};
+    }
+
+    return Result{enable.size(), disable.size(), written, std::chrono::duration_cast<std::chrono::nanoseconds>(frozen_for)};
+}
 } // namespace safetyhook
 
 //
@@ -405,13 +405,20 @@ public:
         [[nodiscard]] static Error not_enough_space(uint8_t* ip) { return {.type = NOT_ENOUGH_SPACE, .ip = ip}; }
     };
 
+    /// @brief Flags for InlineHook.
+    enum Flags : int {
+        Default = 0,            ///< Default flags.
+        StartDisabled = 1 << 0, ///< Start the hook disabled.
+    };
+
     /// @brief Create an inline hook.
     /// @param target The address of the function to hook.
     /// @param destination The destination address.
+    /// @param flags The flags to use.
     /// @return The InlineHook or an InlineHook::Error if an error occurred.
     /// @note This will use the default global Allocator.
     /// @note If you don't care about error handling, use the easy API (safetyhook::create_inline).
-    [[nodiscard]] static std::expected<InlineHook, Error> create(void* target, void* destination);
+    [[nodiscard]] static std::expected<InlineHook, Error> create(void* target, void* destination, Flags flags = Default);
 
     /// @brief Create an inline hook.
     /// @param target The address of the function to hook.
@@ -427,10 +434,11 @@ public:
     /// @param allocator The allocator to use.
     /// @param target The address of the function to hook.
     /// @param destination The destination address.
+    /// @param flags The flags to use.
     /// @return The InlineHook or an InlineHook::Error if an error occurred.
     /// @note If you don't care about error handling, use the easy API (safetyhook::create_inline).
     [[nodiscard]] static std::expected<InlineHook, Error> create(
-        const std::shared_ptr<Allocator>& allocator, void* target, void* destination);
+        const std::shared_ptr<Allocator>& allocator, void* target, void* destination, Flags flags = Default);
 
     /// @brief Create an inline hook with a given Allocator.
     /// @param allocator The allocator to use.
@@ -479,6 +487,19 @@ public:
     /// @return True if the hook is valid, false otherwise.
     explicit operator bool() const { return static_cast<bool>(m_trampoline); }
 
+    /// @brief Enable the hook.
+    /// @return Nothing or an InlineHook::Error if an error occurred.
+    /// @note Freezes all other threads while the target is patched. Use a HookBatch to enable many hooks at once.
+    [[nodiscard]] std::expected<void, Error> enable();
+
+    /// @brief Disable the hook.
+    /// @return Nothing or an InlineHook::Error if an error occurred.
+    [[nodiscard]] std::expected<void, Error> disable();
+
+    /// @brief Check if the hook is enabled.
+    /// @return True if the hook is enabled, false otherwise.
+    [[nodiscard]] bool enabled() const { return m_enabled; }
+
     /// @brief Returns the address of the trampoline to call the original function.
     /// @tparam T The type of the function pointer.
     /// @return The address of the trampoline to call the original function.
@@ -605,6 +626,9 @@ public:
 
 private:
     friend class MidHook;
+    friend class HookBatch;
+
+    enum class Type { Unset, E9, FF };
 
     uint8_t* m_target{};
     uint8_t* m_destination{};
@@ -612,6 +636,8 @@ private:
     std::vector<uint8_t> m_original_bytes{};
     uintptr_t m_trampoline_size{};
     std::recursive_mutex m_mutex{};
+    Type m_type{Type::Unset};
+    bool m_enabled{};
 
     std::expected<void, Error> setup(
         const std::shared_ptr<Allocator>& allocator, uint8_t* target, uint8_t* destination);
@@ -621,6 +647,10 @@ private:
     std::expected<void, Error> ff_hook(const std::shared_ptr<Allocator>& allocator);
 #endif
 
+    // Write or restore the jmp at the target. Callers must have frozen all other threads.
+    std::expected<void, Error> patch();
+    void unpatch();
+
     void destroy();
 };
 } // namespace safetyhook
@@ -639,6 +669,7 @@ private:
 #pragma once
 
 #ifndef SAFETYHOOK_USE_CXXMODULES
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #else
@@ -712,6 +743,264 @@ using Context = Context32;
 
 } // namespace safetyhook
 
+//
+// Header: safetyhook/mid_hook_stub.hpp
+//
+// Include stack:
+//   - safetyhook.hpp
+//   - safetyhook/easy.hpp
+//   - safetyhook/mid_hook.hpp
+//
+
+/// @file safetyhook/mid_hook_stub.hpp
+/// @brief Machine code for the stubs that call MidHook destinations.
+
+#pragma once
+
+#ifndef SAFETYHOOK_USE_CXXMODULES
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#else
+import std.compat;
+#endif
+
+namespace safetyhook {
+
+/// @brief A set of registers, one bit per register. See MidHook::create.
+using RegisterMask = uint32_t;
+
+/// @brief Registers a MidHook destination can declare it reads or writes.
+namespace reg {
+inline constexpr RegisterMask none = 0;
+inline constexpr RegisterMask all = ~RegisterMask{0};
+#if SAFETYHOOK_ARCH_X86_64
+// GPR bits follow the x86-64 register encoding.
+inline constexpr RegisterMask rax = 1u << 0;
+inline constexpr RegisterMask rcx = 1u << 1;
+inline constexpr RegisterMask rdx = 1u << 2;
+inline constexpr RegisterMask rbx = 1u << 3;
+inline constexpr RegisterMask rsp = 1u << 4; ///< Fills Context::rsp, which is read-only.
+inline constexpr RegisterMask rbp = 1u << 5;
+inline constexpr RegisterMask rsi = 1u << 6;
+inline constexpr RegisterMask rdi = 1u << 7;
+inline constexpr RegisterMask r8 = 1u << 8;
+inline constexpr RegisterMask r9 = 1u << 9;
+inline constexpr RegisterMask r10 = 1u << 10;
+inline constexpr RegisterMask r11 = 1u << 11;
+inline constexpr RegisterMask r12 = 1u << 12;
+inline constexpr RegisterMask r13 = 1u << 13;
+inline constexpr RegisterMask r14 = 1u << 14;
+inline constexpr RegisterMask r15 = 1u << 15;
+inline constexpr RegisterMask xmm0 = 1u << 16;
+inline constexpr RegisterMask xmm1 = 1u << 17;
+inline constexpr RegisterMask xmm2 = 1u << 18;
+inline constexpr RegisterMask xmm3 = 1u << 19;
+inline constexpr RegisterMask xmm4 = 1u << 20;
+inline constexpr RegisterMask xmm5 = 1u << 21;
+inline constexpr RegisterMask xmm6 = 1u << 22;
+inline constexpr RegisterMask xmm7 = 1u << 23;
+inline constexpr RegisterMask xmm8 = 1u << 24;
+inline constexpr RegisterMask xmm9 = 1u << 25;
+inline constexpr RegisterMask xmm10 = 1u << 26;
+inline constexpr RegisterMask xmm11 = 1u << 27;
+inline constexpr RegisterMask xmm12 = 1u << 28;
+inline constexpr RegisterMask xmm13 = 1u << 29;
+inline constexpr RegisterMask xmm14 = 1u << 30;
+inline constexpr RegisterMask xmm15 = 1u << 31;
+
+/// @brief Registers the destination may clobber under the platform calling convention. Lean stubs always save these.
+#if SAFETYHOOK_OS_WINDOWS
+inline constexpr RegisterMask caller_saved = rax | rcx | rdx | r8 | r9 | r10 | r11 | xmm0 | xmm1 | xmm2 | xmm3 | xmm4 | xmm5;
+#else
+inline constexpr RegisterMask caller_saved = rax | rcx | rdx | rsi | rdi | r8 | r9 | r10 | r11 | 0xFFFF0000u;
+#endif
+#endif
+} // namespace reg
+
+namespace detail {
+#if SAFETYHOOK_ARCH_X86_64
+#if SAFETYHOOK_OS_WINDOWS
+inline constexpr std::array<uint8_t, 391> full_mid_hook_stub = {0xFF, 0x35, 0x79, 0x01, 0x00, 0x00, 0x54, 0x54, 0x55, 0x50, 0x53, 0x51,
+    0x52, 0x56, 0x57, 0x41, 0x50, 0x41, 0x51, 0x41, 0x52, 0x41, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57,
+    0x9C, 0x48, 0x81, 0xEC, 0x00, 0x01, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0xBC, 0x24, 0xF0, 0x00, 0x00, 0x00, 0xF3,
+    0x44, 0x0F, 0x7F, 0xB4, 0x24, 0xE0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0xAC, 0x24, 0xD0, 0x00, 0x00, 0x00,
+    0xF3, 0x44, 0x0F, 0x7F, 0xA4, 0x24, 0xC0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x9C, 0x24, 0xB0, 0x00, 0x00,
+    0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x94, 0x24, 0xA0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x8C, 0x24, 0x90, 0x00,
+    0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x84, 0x24, 0x80, 0x00, 0x00, 0x00, 0xF3, 0x0F, 0x7F, 0x7C, 0x24, 0x70, 0xF3,
+    0x0F, 0x7F, 0x74, 0x24, 0x60, 0xF3, 0x0F, 0x7F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x7F, 0x64, 0x24, 0x40, 0xF3, 0x0F,
+    0x7F, 0x5C, 0x24, 0x30, 0xF3, 0x0F, 0x7F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x7F, 0x4C, 0x24, 0x10, 0xF3, 0x0F, 0x7F,
+    0x04, 0x24, 0x48, 0x8B, 0x8C, 0x24, 0x80, 0x01, 0x00, 0x00, 0x48, 0x83, 0xC1, 0x10, 0x48, 0x89, 0x8C, 0x24, 0x80,
+    0x01, 0x00, 0x00, 0x48, 0x8D, 0x0C, 0x24, 0x48, 0x89, 0xE3, 0x48, 0x83, 0xEC, 0x30, 0x48, 0x83, 0xE4, 0xF0, 0xFF,
+    0x15, 0xA8, 0x00, 0x00, 0x00, 0x48, 0x89, 0xDC, 0xF3, 0x0F, 0x6F, 0x04, 0x24, 0xF3, 0x0F, 0x6F, 0x4C, 0x24, 0x10,
+    0xF3, 0x0F, 0x6F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x6F, 0x5C, 0x24, 0x30, 0xF3, 0x0F, 0x6F, 0x64, 0x24, 0x40, 0xF3,
+    0x0F, 0x6F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x6F, 0x74, 0x24, 0x60, 0xF3, 0x0F, 0x6F, 0x7C, 0x24, 0x70, 0xF3, 0x44,
+    0x0F, 0x6F, 0x84, 0x24, 0x80, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0x8C, 0x24, 0x90, 0x00, 0x00, 0x00, 0xF3,
+    0x44, 0x0F, 0x6F, 0x94, 0x24, 0xA0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0x9C, 0x24, 0xB0, 0x00, 0x00, 0x00,
+    0xF3, 0x44, 0x0F, 0x6F, 0xA4, 0x24, 0xC0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xAC, 0x24, 0xD0, 0x00, 0x00,
+    0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xB4, 0x24, 0xE0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xBC, 0x24, 0xF0, 0x00,
+    0x00, 0x00, 0x48, 0x81, 0xC4, 0x00, 0x01, 0x00, 0x00, 0x9D, 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x41,
+    0x5B, 0x41, 0x5A, 0x41, 0x59, 0x41, 0x58, 0x5F, 0x5E, 0x5A, 0x59, 0x5B, 0x58, 0x5D, 0x48, 0x8D, 0x64, 0x24, 0x08,
+    0x5C, 0xC3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+#elif SAFETYHOOK_OS_LINUX
+inline constexpr std::array<uint8_t, 391> full_mid_hook_stub = {0xFF, 0x35, 0x79, 0x01, 0x00, 0x00, 0x54, 0x54, 0x55, 0x50, 0x53, 0x51,
+    0x52, 0x56, 0x57, 0x41, 0x50, 0x41, 0x51, 0x41, 0x52, 0x41, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57,
+    0x9C, 0x48, 0x81, 0xEC, 0x00, 0x01, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0xBC, 0x24, 0xF0, 0x00, 0x00, 0x00, 0xF3,
+    0x44, 0x0F, 0x7F, 0xB4, 0x24, 0xE0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0xAC, 0x24, 0xD0, 0x00, 0x00, 0x00,
+    0xF3, 0x44, 0x0F, 0x7F, 0xA4, 0x24, 0xC0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x9C, 0x24, 0xB0, 0x00, 0x00,
+    0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x94, 0x24, 0xA0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x8C, 0x24, 0x90, 0x00,
+    0x00, 0x00, 0xF3, 0x44, 0x0F, 0x7F, 0x84, 0x24, 0x80, 0x00, 0x00, 0x00, 0xF3, 0x0F, 0x7F, 0x7C, 0x24, 0x70, 0xF3,
+    0x0F, 0x7F, 0x74, 0x24, 0x60, 0xF3, 0x0F, 0x7F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x7F, 0x64, 0x24, 0x40, 0xF3, 0x0F,
+    0x7F, 0x5C, 0x24, 0x30, 0xF3, 0x0F, 0x7F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x7F, 0x4C, 0x24, 0x10, 0xF3, 0x0F, 0x7F,
+    0x04, 0x24, 0x48, 0x8B, 0xBC, 0x24, 0x80, 0x01, 0x00, 0x00, 0x48, 0x83, 0xC7, 0x10, 0x48, 0x89, 0xBC, 0x24, 0x80,
+    0x01, 0x00, 0x00, 0x48, 0x8D, 0x3C, 0x24, 0x48, 0x89, 0xE3, 0x48, 0x83, 0xEC, 0x30, 0x48, 0x83, 0xE4, 0xF0, 0xFF,
+    0x15, 0xA8, 0x00, 0x00, 0x00, 0x48, 0x89, 0xDC, 0xF3, 0x0F, 0x6F, 0x04, 0x24, 0xF3, 0x0F, 0x6F, 0x4C, 0x24, 0x10,
+    0xF3, 0x0F, 0x6F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x6F, 0x5C, 0x24, 0x30, 0xF3, 0x0F, 0x6F, 0x64, 0x24, 0x40, 0xF3,
+    0x0F, 0x6F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x6F, 0x74, 0x24, 0x60, 0xF3, 0x0F, 0x6F, 0x7C, 0x24, 0x70, 0xF3, 0x44,
+    0x0F, 0x6F, 0x84, 0x24, 0x80, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0x8C, 0x24, 0x90, 0x00, 0x00, 0x00, 0xF3,
+    0x44, 0x0F, 0x6F, 0x94, 0x24, 0xA0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0x9C, 0x24, 0xB0, 0x00, 0x00, 0x00,
+    0xF3, 0x44, 0x0F, 0x6F, 0xA4, 0x24, 0xC0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xAC, 0x24, 0xD0, 0x00, 0x00,
+    0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xB4, 0x24, 0xE0, 0x00, 0x00, 0x00, 0xF3, 0x44, 0x0F, 0x6F, 0xBC, 0x24, 0xF0, 0x00,
+    0x00, 0x00, 0x48, 0x81, 0xC4, 0x00, 0x01, 0x00, 0x00, 0x9D, 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x41,
+    0x5B, 0x41, 0x5A, 0x41, 0x59, 0x41, 0x58, 0x5F, 0x5E, 0x5A, 0x59, 0x5B, 0x58, 0x5D, 0x48, 0x8D, 0x64, 0x24, 0x08,
+    0x5C, 0xC3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+#endif
+#elif SAFETYHOOK_ARCH_X86_32
+inline constexpr std::array<uint8_t, 171> full_mid_hook_stub = {0xFF, 0x35, 0xA7, 0x00, 0x00, 0x00, 0x54, 0x54, 0x55, 0x50, 0x53, 0x51,
+    0x52, 0x56, 0x57, 0x9C, 0x81, 0xEC, 0x80, 0x00, 0x00, 0x00, 0xF3, 0x0F, 0x7F, 0x7C, 0x24, 0x70, 0xF3, 0x0F, 0x7F,
+    0x74, 0x24, 0x60, 0xF3, 0x0F, 0x7F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x7F, 0x64, 0x24, 0x40, 0xF3, 0x0F, 0x7F, 0x5C,
+    0x24, 0x30, 0xF3, 0x0F, 0x7F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x7F, 0x4C, 0x24, 0x10, 0xF3, 0x0F, 0x7F, 0x04, 0x24,
+    0x8B, 0x8C, 0x24, 0xA0, 0x00, 0x00, 0x00, 0x83, 0xC1, 0x08, 0x89, 0x8C, 0x24, 0xA0, 0x00, 0x00, 0x00, 0x54, 0xFF,
+    0x15, 0xA3, 0x00, 0x00, 0x00, 0x83, 0xC4, 0x04, 0xF3, 0x0F, 0x6F, 0x04, 0x24, 0xF3, 0x0F, 0x6F, 0x4C, 0x24, 0x10,
+    0xF3, 0x0F, 0x6F, 0x54, 0x24, 0x20, 0xF3, 0x0F, 0x6F, 0x5C, 0x24, 0x30, 0xF3, 0x0F, 0x6F, 0x64, 0x24, 0x40, 0xF3,
+    0x0F, 0x6F, 0x6C, 0x24, 0x50, 0xF3, 0x0F, 0x6F, 0x74, 0x24, 0x60, 0xF3, 0x0F, 0x6F, 0x7C, 0x24, 0x70, 0x81, 0xC4,
+    0x80, 0x00, 0x00, 0x00, 0x9D, 0x5F, 0x5E, 0x5A, 0x59, 0x5B, 0x58, 0x5D, 0x8D, 0x64, 0x24, 0x04, 0x5C, 0xC3, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+#endif
+
+#if SAFETYHOOK_ARCH_X86_64
+/// @brief Builds a stub that only saves and restores the given registers plus reg::caller_saved and rflags.
+/// @details The destination still gets a full Context64 on the stack, but only the saved fields hold anything.
+/// Writes to rip and trampoline_rsp are ignored, the stub always resumes at the trampoline.
+/// The last 16 bytes are the destination and trampoline addresses, laid out like the full stub.
+inline std::vector<uint8_t> lean_mid_hook_stub(RegisterMask registers) {
+    constexpr auto frame_size = static_cast<int32_t>(sizeof(Context64));
+    constexpr auto rflags_offset = static_cast<int32_t>(offsetof(Context64, rflags));
+    constexpr std::array<size_t, 16> gpr_offsets{offsetof(Context64, rax), offsetof(Context64, rcx),
+        offsetof(Context64, rdx), offsetof(Context64, rbx), offsetof(Context64, rsp), offsetof(Context64, rbp),
+        offsetof(Context64, rsi), offsetof(Context64, rdi), offsetof(Context64, r8), offsetof(Context64, r9),
+        offsetof(Context64, r10), offsetof(Context64, r11), offsetof(Context64, r12), offsetof(Context64, r13),
+        offsetof(Context64, r14), offsetof(Context64, r15)};
+
+    const auto saved = (registers | reg::caller_saved) & ~reg::rsp;
+    std::vector<uint8_t> code;
+
+    auto emit = [&code](std::initializer_list<uint8_t> bytes) { code.insert(code.end(), bytes); };
+    auto emit32 = [&code](int32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            code.push_back(static_cast<uint8_t>(static_cast<uint32_t>(value) >> (i * 8)));
+        }
+    };
+    // lea rsp, [rsp + disp32]
+    auto adjust_rsp = [&](int32_t disp) {
+        emit({0x48, 0x8D, 0xA4, 0x24});
+        emit32(disp);
+    };
+    // mov [rsp + disp32], r64 (0x89) or mov r64, [rsp + disp32] (0x8B)
+    auto gpr = [&](uint8_t opcode, int index, size_t disp) {
+        emit({static_cast<uint8_t>(index >= 8 ? 0x4C : 0x48), opcode, static_cast<uint8_t>(0x84 | ((index & 7) << 3)), 0x24});
+        emit32(static_cast<int32_t>(disp));
+    };
+    // movdqu [rsp + disp32], xmm (0x7F) or movdqu xmm, [rsp + disp32] (0x6F)
+    auto xmm = [&](uint8_t opcode, int index, size_t disp) {
+        emit({0xF3});
+        if (index >= 8) {
+            emit({0x44});
+        }
+        emit({0x0F, opcode, static_cast<uint8_t>(0x84 | ((index & 7) << 3)), 0x24});
+        emit32(static_cast<int32_t>(disp + index * sizeof(Xmm)));
+    };
+
+    // Make room for a Context64 below the hooked code's stack and put rflags in its slot.
+    adjust_rsp(-(frame_size - rflags_offset - 8));
+    emit({0x9C}); // pushfq
+    adjust_rsp(-rflags_offset);
+
+    for (int i = 0; i < 16; ++i) {
+        if (saved & (1u << i)) {
+            gpr(0x89, i, gpr_offsets[i]);
+        }
+    }
+    for (int i = 0; i < 16; ++i) {
+        if (saved & (1u << (16 + i))) {
+            xmm(0x7F, i, offsetof(Context64, xmm0));
+        }
+    }
+    if (registers & reg::rsp) {
+        emit({0x48, 0x8D, 0x84, 0x24}); // lea rax, [rsp + frame_size]
+        emit32(frame_size);
+        gpr(0x89, 0, gpr_offsets[4]);
+    }
+
+    // Align the stack for the call and keep the context pointer above the shadow space to restore rsp from.
+    emit({0x48, 0x89, 0xE0});             // mov rax, rsp
+    emit({0x48, 0x83, 0xE4, 0xF0});       // and rsp, -16
+    emit({0x48, 0x83, 0xEC, 0x30});       // sub rsp, 0x30
+    emit({0x48, 0x89, 0x44, 0x24, 0x28}); // mov [rsp + 0x28], rax
+#if SAFETYHOOK_OS_WINDOWS
+    emit({0x48, 0x89, 0xC1}); // mov rcx, rax
+#else
+    emit({0x48, 0x89, 0xC7}); // mov rdi, rax
+#endif
+    emit({0xFF, 0x15}); // call [rip + destination]
+    const auto call_disp = code.size();
+    emit32(0);
+    emit({0x48, 0x8B, 0x64, 0x24, 0x28}); // mov rsp, [rsp + 0x28]
+
+    for (int i = 0; i < 16; ++i) {
+        if (saved & (1u << (16 + i))) {
+            xmm(0x6F, i, offsetof(Context64, xmm0));
+        }
+    }
+    for (int i = 0; i < 16; ++i) {
+        if (saved & (1u << i)) {
+            gpr(0x8B, i, gpr_offsets[i]);
+        }
+    }
+
+    adjust_rsp(rflags_offset);
+    emit({0x9D}); // popfq
+    adjust_rsp(frame_size - rflags_offset - 8);
+    emit({0xFF, 0x25}); // jmp [rip + trampoline]
+    const auto jmp_disp = code.size();
+    emit32(0);
+
+    while (code.size() % 8 != 0) {
+        code.push_back(0xCC);
+    }
+    const auto destination_slot = code.size();
+    code.resize(code.size() + 16, 0x00);
+
+    store(code.data() + call_disp, static_cast<int32_t>(destination_slot - (call_disp + 4)));
+    store(code.data() + jmp_disp, static_cast<int32_t>(destination_slot + 8 - (jmp_disp + 4)));
+    return code;
+}
+#endif
+
+/// @brief The stub for a MidHook whose destination uses the given registers.
+inline std::vector<uint8_t> mid_hook_stub([[maybe_unused]] RegisterMask registers) {
+#if SAFETYHOOK_ARCH_X86_64
+    if (registers != reg::all) {
+        return lean_mid_hook_stub(registers);
+    }
+#endif
+    return {full_mid_hook_stub.begin(), full_mid_hook_stub.end()};
+}
+} // namespace detail
+
+} // namespace safetyhook
+
 namespace safetyhook {
 
 /// @brief A MidHook destination function.
@@ -749,13 +1038,23 @@ public:
         }
     };
 
+    /// @brief Flags for MidHook.
+    enum Flags : int {
+        Default = 0,            ///< Default flags.
+        StartDisabled = 1 << 0, ///< Start the hook disabled.
+    };
+
     /// @brief Creates a new MidHook object.
     /// @param target The address of the function to hook.
     /// @param destination_fn The destination function.
+    /// @param flags The flags to use.
+    /// @param registers The registers destination_fn reads or writes. Anything other than reg::all gets a lean stub
+    /// that leaves the rest of the Context uninitialized and ignores changes to rip. See detail::lean_mid_hook_stub.
     /// @return The MidHook object or a MidHook::Error if an error occurred.
     /// @note This will use the default global Allocator.
     /// @note If you don't care about error handling, use the easy API (safetyhook::create_mid).
-    [[nodiscard]] static std::expected<MidHook, Error> create(void* target, MidHookFn destination_fn);
+    [[nodiscard]] static std::expected<MidHook, Error> create(
+        void* target, MidHookFn destination_fn, Flags flags = Default, RegisterMask registers = reg::all);
 
     /// @brief Creates a new MidHook object.
     /// @param target The address of the function to hook.
@@ -771,10 +1070,12 @@ public:
     /// @param allocator The Allocator to use.
     /// @param target The address of the function to hook.
     /// @param destination_fn The destination function.
+    /// @param flags The flags to use.
+    /// @param registers The registers destination_fn reads or writes.
     /// @return The MidHook object or a MidHook::Error if an error occurred.
     /// @note If you don't care about error handling, use the easy API (safetyhook::create_mid).
-    [[nodiscard]] static std::expected<MidHook, Error> create(
-        const std::shared_ptr<Allocator>& allocator, void* target, MidHookFn destination_fn);
+    [[nodiscard]] static std::expected<MidHook, Error> create(const std::shared_ptr<Allocator>& allocator, void* target,
+        MidHookFn destination_fn, Flags flags = Default, RegisterMask registers = reg::all);
 
     /// @brief Creates a new MidHook object with a given Allocator.
     /// @tparam T The type of the function to hook.
@@ -820,14 +1121,74 @@ public:
     /// @return true if the hook is valid, false otherwise.
     explicit operator bool() const { return static_cast<bool>(m_stub); }
 
+    /// @brief Enable the hook.
+    /// @return Nothing or a MidHook::Error if an error occurred.
+    [[nodiscard]] std::expected<void, Error> enable();
+
+    /// @brief Disable the hook.
+    /// @return Nothing or a MidHook::Error if an error occurred.
+    [[nodiscard]] std::expected<void, Error> disable();
+
+    /// @brief Check if the hook is enabled.
+    /// @return True if the hook is enabled, false otherwise.
+    [[nodiscard]] bool enabled() const { return m_hook.enabled(); }
+
 private:
+    friend class HookBatch;
+
     InlineHook m_hook{};
     uint8_t* m_target{};
     Allocation m_stub{};
     MidHookFn m_destination{};
 
-    std::expected<void, Error> setup(
-        const std::shared_ptr<Allocator>& allocator, uint8_t* target, MidHookFn destination);
+    std::expected<void, Error> setup(const std::shared_ptr<Allocator>& allocator, uint8_t* target, MidHookFn destination,
+        Flags flags, RegisterMask registers);
+};
+
+/// @brief Enables and disables a set of hooks under a single thread freeze.
+/// @details Creating or enabling hooks one by one suspends every other thread once per hook. Create the hooks with
+/// StartDisabled, add them to a HookBatch and commit it to patch them all while the threads are frozen once.
+class HookBatch final {
+public:
+    /// @brief The result of a committed batch.
+    struct Result {
+        size_t enabled;                      ///< Number of hooks that were enabled.
+        size_t disabled;                     ///< Number of hooks that were disabled.
+        size_t written;                      ///< Number of queued writes that were applied.
+        std::chrono::nanoseconds frozen_for; ///< How long all other threads were frozen for.
+    };
+
+    /// @brief Queue an inline hook to be enabled. Invalid or already enabled hooks are ignored on commit.
+    void add(InlineHook& hook) { m_enable.push_back(&hook); }
+
+    /// @brief Queue a mid hook to be enabled. Invalid or already enabled hooks are ignored on commit.
+    void add(MidHook& hook) { m_enable.push_back(&hook.m_hook); }
+
+    /// @brief Queue an inline hook to be disabled. Already disabled hooks are ignored on commit.
+    void remove(InlineHook& hook) { m_disable.push_back(&hook); }
+
+    /// @brief Queue a mid hook to be disabled. Already disabled hooks are ignored on commit.
+    void remove(MidHook& hook) { m_disable.push_back(&hook.m_hook); }
+
+    /// @brief Queue bytes to be written while the threads are frozen, for patches that must never be seen half written.
+    /// @details Meant for operands inside an instruction (e.g. a displacement), so no thread is ever moved. The write
+    /// must not change where any instruction starts.
+    void write(uint8_t* address, std::vector<uint8_t> bytes) { m_writes.emplace_back(address, std::move(bytes)); }
+
+    /// @brief Get the number of hooks and writes in the batch.
+    [[nodiscard]] size_t size() const { return m_enable.size() + m_disable.size() + m_writes.size(); }
+
+    /// @brief Apply every queued change with one freeze. Thread IPs are fixed up for all hooks together.
+    /// @return The Result or an InlineHook::Error if any hook failed to patch.
+    /// @note Enabling is all or nothing. If any hook fails to patch, the hooks enabled by this commit are restored.
+    /// Queued disables and writes are always applied.
+    /// @note The batch is empty after committing.
+    [[nodiscard]] std::expected<Result, InlineHook::Error> commit();
+
+private:
+    std::vector<InlineHook*> m_enable{};
+    std::vector<InlineHook*> m_disable{};
+    std::vector<std::pair<uint8_t*, std::vector<uint8_t>>> m_writes{};
 };
 } // namespace safetyhook
 
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <Zydis.h>
+
+#include "patternscan.hpp"
+#include "pe.hpp"
+
+// Instruction-level view of the game's code, built with one decode pass using the Zydis decoder bundled with safetyhook.
+namespace Disasm
+{
+    // What an instruction pattern expects of an operand
+    enum class Operand : std::uint8_t { Any, Gpr, Xmm, Mem, Imm };
+
+    // One instruction of a pattern. Operands not listed match anything.
+    struct Insn
+    {
+        ZydisMnemonic mnemonic;
+        std::array<Operand, 3> operands{};
+    };
+
+    // A signature written as instructions, filled in through Signature so hooks use it like any other.
+    // Matches always start on an instruction boundary, no matter what the surrounding bytes are.
+    struct InsnSignature
+    {
+        Memory::Signature* signature;
+        std::vector<Insn> pattern;
+    };
+
+    class CodeIndex
+    {
+    public:
+        // Decodes every executable section. Functions from the exception directory are used as sync points and
+        // decoded in parallel, the gaps between them are swept linearly. bNgrams also indexes every run of three
+        // mnemonics for Find(), which costs 8 bytes per instruction.
+        CodeIndex(const Pe::Image& image, bool bNgrams = false, unsigned int workers = Scanner::DefaultWorkers())
+        {
+            ZydisDecoderInit(&_decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
+            for (const auto& range : image.Ranges(Scanner::Section::Code))
+                _ranges.push_back({ range, std::vector<std::atomic<uint64_t>>((range.size + 63) / 64) });
+
+            _segments = Segments(image);
+            const auto& segments = _segments;
+            std::vector<std::vector<Ngram>> ngrams(segments.size());
+            std::atomic<size_t> next = 0;
+            auto worker = [&] {
+                ZydisDecoder decoder = _decoder;
+                for (size_t i = next++; i < segments.size(); i = next++)
+                    Decode(decoder, segments[i], bNgrams ? &ngrams[i] : nullptr);
+            };
+
+            workers = (unsigned int)(std::min)((size_t)(std::max)(workers, 1u), segments.size());
+            std::vector<std::thread> threads;
+            for (unsigned int i = 1; i < workers; ++i)
+                threads.emplace_back(worker);
+            worker();
+            for (auto& thread : threads)
+                thread.join();
+
+            for (auto& segment : ngrams)
+                _ngrams.insert(_ngrams.end(), segment.begin(), segment.end());
+            std::sort(_ngrams.begin(), _ngrams.end(), [](const Ngram& a, const Ngram& b) { return a.key < b.key || (a.key == b.key && a.address < b.address); });
+        }
+
+        // Whether address is the first byte of an instruction found by the decode pass
+        bool IsBoundary(const std::uint8_t* address) const
+        {
+            for (const auto& range : _ranges) {
+                if (address >= range.code.data && address < range.code.data + range.code.size) {
+                    size_t offset = address - range.code.data;
+                    return (range.boundaries[offset / 64].load(std::memory_order_relaxed) >> (offset % 64)) & 1;
+                }
+            }
+            return false;
+        }
+
+        size_t InstructionCount() const { return _instructions; }
+
+        // Whether a relative jump, branch or call in the same function (or gap between functions) lands on address.
+        // Jump tables and branches from other functions aren't seen, only code that's part of the function can be trusted this way.
+        bool IsBranchTarget(const std::uint8_t* address) const
+        {
+            auto segment = std::upper_bound(_segments.begin(), _segments.end(), address, [](const std::uint8_t* address, const Segment& segment) { return address < segment.begin; });
+            if (segment == _segments.begin() || address >= (--segment)->end)
+                return false;
+
+            ZydisDecodedInstruction ix;
+            ZydisDecodedOperand operands[ZYDIS_MAX_OPERAND_COUNT];
+            for (auto ip = segment->begin; ip < segment->end;) {
+                if (!ZYAN_SUCCESS(ZydisDecoderDecodeFull(&_decoder, ip, segment->end - ip, &ix, operands))) {
+                    ++ip;
+                    continue;
+                }
+                ZyanU64 destination;
+                if ((ix.attributes & ZYDIS_ATTRIB_IS_RELATIVE) && ix.operand_count_visible > 0 && operands[0].type == ZYDIS_OPERAND_TYPE_IMMEDIATE &&
+                    ZYAN_SUCCESS(ZydisCalcAbsoluteAddress(&ix, &operands[0], (ZyanU64)ip, &destination)) && destination == (ZyanU64)address)
+                    return true;
+                ip += ix.length;
+            }
+            return false;
+        }
+
+        // Every place the instructions appear back to back, in address order, up to limit matches.
+        // Patterns of three or more instructions are looked up through the n-gram index when there is one, anything else checks every boundary.
+        std::vector<std::uint8_t*> Find(std::span<const Insn> pattern, size_t limit = SIZE_MAX) const
+        {
+            std::vector<std::uint8_t*> found;
+            if (pattern.empty())
+                return found;
+
+            if (pattern.size() >= 3 && !_ngrams.empty()) {
+                auto key = Key(pattern[0].mnemonic, pattern[1].mnemonic, pattern[2].mnemonic);
+                auto first = std::lower_bound(_ngrams.begin(), _ngrams.end(), key, [](const Ngram& ngram, uint32_t key) { return ngram.key < key; });
+                for (auto it = first; it != _ngrams.end() && it->key == key && found.size() < limit; ++it) {
+                    if (Matches(it->address, pattern))
+                        found.push_back(it->address);
+                }
+                return found;
+            }
+
+            for (const auto& range : _ranges) {
+                for (size_t word = 0; word < range.boundaries.size() && found.size() < limit; ++word) {
+                    for (auto bits = range.boundaries[word].load(std::memory_order_relaxed); bits && found.size() < limit; bits &= bits - 1) {
+                        auto address = range.code.data + word * 64 + std::countr_zero(bits);
+                        if (Matches(address, pattern))
+                            found.push_back(address);
+                    }
+                }
+            }
+            return found;
+        }
+
+        // Resolves instruction signatures the same way Memory::PatternScan resolves byte ones, by expected match count and index
+        void Resolve(std::span<InsnSignature> signatures) const
+        {
+            for (auto& insn : signatures) {
+                auto& signature = *insn.signature;
+                auto found = Find(insn.pattern, (std::max)(signature.expected, signature.index + 1) + 1);
+                signature.matches = found.size();
+                signature.address = Memory::Pick(signature, found);
+            }
+        }
+
+    private:
+        struct CodeRange
+        {
+            Pe::Range code;
+            std::vector<std::atomic<uint64_t>> boundaries; // One bit per byte
+        };
+
+        struct Segment
+        {
+            std::uint8_t* begin;
+            std::uint8_t* end;
+            CodeRange* range;
+        };
+
+        struct Ngram
+        {
+            uint32_t key;
+            std::uint8_t* address;
+        };
+
+        ZydisDecoder _decoder{};
+        std::vector<CodeRange> _ranges;
+        std::vector<Segment> _segments;     // In address order
+        std::vector<Ngram> _ngrams;
+        std::atomic<size_t> _instructions = 0;
+
+        static uint32_t Key(ZydisMnemonic a, ZydisMnemonic b, ZydisMnemonic c)
+        {
+            return ((uint32_t)a << 22) ^ ((uint32_t)b << 11) ^ (uint32_t)c;
+        }
+
+        // Splits the code into functions and the gaps between them
+        std::vector<Segment> Segments(const Pe::Image& image)
+        {
+            std::vector<Segment> segments;
+            auto functions = image.Functions();
+            auto function = functions.begin();
+            for (auto& range : _ranges) {
+                auto cursor = range.code.rva;
+                auto end = range.code.rva + (uint32_t)range.code.size;
+                auto add = [&](uint32_t begin, uint32_t stop) {
+                    if (stop > begin)
+                        segments.push_back({ range.code.data + (begin - range.code.rva), range.code.data + (stop - range.code.rva), &range });
+                };
+
+                for (; function != functions.end() && function->begin < end; ++function) {
+                    if (function->begin < cursor || function->end > end || function->end <= function->begin)
+                        continue; // Overlapping, or outside what's readable
+                    add(cursor, function->begin);
+                    add(function->begin, function->end);
+                    cursor = function->end;
+                }
+                add(cursor, end);
+            }
+            return segments;
+        }
+
+        void Decode(const ZydisDecoder& decoder, const Segment& segment, std::vector<Ngram>* ngrams)
+        {
+            auto& range = *segment.range;
+            std::array<ZydisMnemonic, 3> window{};
+            std::array<std::uint8_t*, 3> starts{};
+            size_t count = 0;
+            size_t instructions = 0;
+            uint64_t word = 0;
+            size_t wordIndex = SIZE_MAX;
+            auto flush = [&] {
+                if (wordIndex != SIZE_MAX && word)
+                    range.boundaries[wordIndex].fetch_or(word, std::memory_order_relaxed);
+            };
+
+            ZydisDecodedInstruction ix;
+            for (auto ip = segment.begin; ip < segment.end;) {
+                if (!ZYAN_SUCCESS(ZydisDecoderDecodeInstruction(&decoder, nullptr, ip, segment.end - ip, &ix))) {
+                    // Data or padding, step over it a byte at a time until decoding picks back up
+                    ++ip;
+                    count = 0;
+                    continue;
+                }
+
+                size_t offset = ip - range.code.data;
+                if (offset / 64 != wordIndex) {
+                    flush();
+                    wordIndex = offset / 64;
+                    word = 0;
+                }
+                word |= 1ull << (offset % 64);
+
+                if (ngrams) {
+                    window[count % 3] = ix.mnemonic;
+                    starts[count % 3] = ip;
+                    if (++count >= 3) {
+                        auto oldest = count % 3;
+                        ngrams->push_back({ Key(window[oldest], window[(oldest + 1) % 3], window[(oldest + 2) % 3]), starts[oldest] });
+                    }
+                }
+                ++instructions;
+                ip += ix.length;
+            }
+            flush();
+            _instructions.fetch_add(instructions, std::memory_order_relaxed);
+        }
+
+        static Operand Kind(const ZydisDecodedOperand& operand)
+        {
+            switch (operand.type) {
+            case ZYDIS_OPERAND_TYPE_MEMORY: return Operand::Mem;
+            case ZYDIS_OPERAND_TYPE_IMMEDIATE: return Operand::Imm;
+            case ZYDIS_OPERAND_TYPE_REGISTER:
+                switch (ZydisRegisterGetClass(operand.reg.value)) {
+                case ZYDIS_REGCLASS_GPR8:
+                case ZYDIS_REGCLASS_GPR16:
+                case ZYDIS_REGCLASS_GPR32:
+                case ZYDIS_REGCLASS_GPR64: return Operand::Gpr;
+                case ZYDIS_REGCLASS_XMM: return Operand::Xmm;
+                default: return Operand::Any;
+                }
+            default: return Operand::Any;
+            }
+        }
+
+        bool Matches(std::uint8_t* address, std::span<const Insn> pattern) const
+        {
+            const CodeRange* range = nullptr;
+            for (const auto& candidate : _ranges) {
+                if (address >= candidate.code.data && address < candidate.code.data + candidate.code.size)
+                    range = &candidate;
+            }
+            if (!range)
+                return false;
+
+            auto end = range->code.data + range->code.size;
+            ZydisDecodedInstruction ix;
+            ZydisDecodedOperand operands[ZYDIS_MAX_OPERAND_COUNT];
+            for (const auto& insn : pattern) {
+                if (address >= end || !ZYAN_SUCCESS(ZydisDecoderDecodeFull(&_decoder, address, end - address, &ix, operands)) || ix.mnemonic != insn.mnemonic)
+                    return false;
+                for (size_t i = 0; i < insn.operands.size(); ++i) {
+                    if (insn.operands[i] == Operand::Any)
+                        continue;
+                    if (i >= ix.operand_count_visible || Kind(operands[i]) != insn.operands[i])
+                        return false;
+                }
+                address += ix.length;
+            }
+            return true;
+        }
+    };
+}
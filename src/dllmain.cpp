@@ -1,11 +1,21 @@
 #include "stdafx.h"
 #include "helper.hpp"
 
+#include <future>
+
 #include <inipp/inipp.h>
 #include <spdlog/spdlog.h>
-#include <spdlog/sinks/base_sink.h>
 #include <safetyhook.hpp>
 
+#include "hooks.hpp"
+#include "layout.hpp"
+#include "elements.hpp"
+#include "logging.hpp"
+#include "pacing.hpp"
+#include "trace.hpp"
+#include "signatures.hpp"
+#include "patch.hpp"
+
 HMODULE baseModule = GetModuleHandle(NULL);
 HMODULE thisModule; // Fix DLL
 
@@ -16,6 +26,7 @@ std::string sLogFile = sFixName + ".log";
 
 // Logger
 std::shared_ptr<spdlog::logger> logger;
+std::shared_ptr<async_file_sink> logSink;
 std::filesystem::path sExePath;
 std::string sExeName;
 std::filesystem::path sThisModulePath;
@@ -23,6 +34,7 @@ std::filesystem::path sThisModulePath;
 // Ini
 inipp::Ini<char> ini;
 std::string sConfigFile = sFixName + ".ini";
+std::string sCacheFile = sFixName + ".cache";
 std::pair DesktopDimensions = { 0,0 };
 
 // Ini variables
@@ -34,102 +46,60 @@ bool bFixAspect;
 bool bFixHUD;
 bool bSkipIntro;
 int iFramerateCap;
-float fGameplayFOVMulti;
+std::atomic<bool> bFrameLimiter;
+std::atomic<int> iFrameStatsInterval;
+std::atomic<float> fGameplayFOVMulti; // Read by hooks while the config can be reloaded, see ReloadConfiguration()
 int iShadowResolution;
 bool bRenderTextureRes;
+bool bProfiling;
+int iProfilingInterval = 10;
+bool bTrace;
+int iTraceHotkey = 121;
+int iTraceDumpAfter;
 
 // Aspect ratio + HUD stuff
+// Everything derived from the current resolution is published as a Layout::Snapshot, see CalculateAspectRatio()
 float fPi = (float)3.141592653;
-float fAspectRatio;
 float fNativeAspect = (float)16 / 9;
-float fAspectMultiplier;
-float fHUDWidth;
-float fHUDHeight;
-float fHUDWidthOffset;
-float fHUDHeightOffset;
 
 // Variables
 int iCurrentResX;
 int iCurrentResY;
 float fCurrentFrametime = 0.0166666f;
+std::unique_ptr<Pacing::Limiter<Pacing::WaitableTimerClock>> frameLimiter;
+Pacing::FrameStats<> frameStats;
+// Patches are kept so they can be reverted on reload
+Memory::PatchTransaction resolutionListPatch;
+Memory::PatchTransaction resCheckPatch;
+Memory::PatchTransaction framerateCapPatch;
+Memory::PatchTransaction shadowQualityPatch;
+// Instruction boundaries of the game's code, hooks are checked against it before they're placed
+std::unique_ptr<Disasm::CodeIndex> codeIndex;
+// Where deferred signatures were found in the exe on disk, the watcher checks there first
+std::unordered_map<const Memory::Signature*, std::uint8_t*> diskHints;
 bool bIsMoviePlaying = false;
 
 void CalculateAspectRatio(bool bLog)
 {
-    // Calculate aspect ratio
-    fAspectRatio = (float)iCurrentResX / (float)iCurrentResY;
-    fAspectMultiplier = fAspectRatio / fNativeAspect;
-
-    // HUD variables
-    fHUDWidth = iCurrentResY * fNativeAspect;
-    fHUDHeight = (float)iCurrentResY;
-    fHUDWidthOffset = (float)(iCurrentResX - fHUDWidth) / 2;
-    fHUDHeightOffset = 0;
-    if (fAspectRatio < fNativeAspect) {
-        fHUDWidth = (float)iCurrentResX;
-        fHUDHeight = (float)iCurrentResX / fNativeAspect;
-        fHUDWidthOffset = 0;
-        fHUDHeightOffset = (float)(iCurrentResY - fHUDHeight) / 2;
-    }
+    // Calculate aspect ratio + HUD variables and publish them to the hooks in one go
+    auto layout = Layout::Compute(iCurrentResX, iCurrentResY, fNativeAspect);
+    Layout::Publish(layout);
+    Hooks::SetLayout(layout);
 
     if (bLog) {
         // Log details about current resolution
         spdlog::info("----------");
-        spdlog::info("Current Resolution: Resolution: {}x{}", iCurrentResX, iCurrentResY);
-        spdlog::info("Current Resolution: fAspectRatio: {}", fAspectRatio);
-        spdlog::info("Current Resolution: fAspectMultiplier: {}", fAspectMultiplier);
-        spdlog::info("Current Resolution: fHUDWidth: {}", fHUDWidth);
-        spdlog::info("Current Resolution: fHUDHeight: {}", fHUDHeight);
-        spdlog::info("Current Resolution: fHUDWidthOffset: {}", fHUDWidthOffset);
-        spdlog::info("Current Resolution: fHUDHeightOffset: {}", fHUDHeightOffset);
+        spdlog::info("Current Resolution: Resolution: {}x{}", layout.resX, layout.resY);
+        spdlog::info("Current Resolution: fAspectRatio: {}", layout.aspectRatio);
+        spdlog::info("Current Resolution: fAspectMultiplier: {}", layout.aspectRatio / fNativeAspect);
+        spdlog::info("Current Resolution: fHUDWidth: {}", layout.hudWidth);
+        spdlog::info("Current Resolution: fHUDHeight: {}", layout.hudHeight);
+        spdlog::info("Current Resolution: fHUDWidthOffset: {}", (layout.resX - layout.hudWidth) / 2);
+        spdlog::info("Current Resolution: fHUDHeightOffset: {}", (layout.resY - layout.hudHeight) / 2);
         spdlog::info("----------");
     }   
 }
 
-// Spdlog sink (truncate on startup, single file)
-template<typename Mutex>
-class size_limited_sink : public spdlog::sinks::base_sink<Mutex> {
-public:
-    explicit size_limited_sink(const std::string& filename, size_t max_size)
-        : _filename(filename), _max_size(max_size) {
-        truncate_log_file();
-
-        _file.open(_filename, std::ios::app);
-        if (!_file.is_open()) {
-            throw spdlog::spdlog_ex("Failed to open log file " + filename);
-        }
-    }
-
-protected:
-    void sink_it_(const spdlog::details::log_msg& msg) override {
-        if (std::filesystem::exists(_filename) && std::filesystem::file_size(_filename) >= _max_size) {
-            return;
-        }
-
-        spdlog::memory_buf_t formatted;
-        this->formatter_->format(msg, formatted);
-
-        _file.write(formatted.data(), formatted.size());
-        _file.flush();
-    }
-
-    void flush_() override {
-        _file.flush();
-    }
-
-private:
-    std::ofstream _file;
-    std::string _filename;
-    size_t _max_size;
-
-    void truncate_log_file() {
-        if (std::filesystem::exists(_filename)) {
-            std::ofstream ofs(_filename, std::ofstream::out | std::ofstream::trunc);
-            ofs.close();
-        }
-    }
-};
-
 void Logging()
 {
     // Get this module path
@@ -148,11 +118,12 @@ void Logging()
     // spdlog initialisation
     {
         try {
-            // Create 10MB truncated logger
-            logger = logger = std::make_shared<spdlog::logger>(sLogFile, std::make_shared<size_limited_sink<std::mutex>>(sThisModulePath.string() + sLogFile, 10 * 1024 * 1024));
+            // Create 10MB truncated logger, written from a background thread so logging from hooks never waits on the disk
+            logSink = std::make_shared<async_file_sink>(sThisModulePath.string() + sLogFile, 10 * 1024 * 1024);
+            logSink->flush_on_crash();
+            logger = std::make_shared<spdlog::logger>(sLogFile, logSink);
             spdlog::set_default_logger(logger);
 
-            spdlog::flush_on(spdlog::level::debug);
             spdlog::info("----------");
             spdlog::info("{} v{} loaded.", sFixName.c_str(), sFixVer.c_str());
             spdlog::info("----------");
@@ -176,6 +147,60 @@ void Logging()
     }
 }
 
+// Settings that can be changed while the game is running, see ReloadConfiguration()
+void ParseConfig()
+{
+    inipp::get_value(ini.sections["Fix FOV"], "Enabled", bFixFOV);
+    spdlog::info("Config Parse: bFixFOV: {}", bFixFOV);
+
+    inipp::get_value(ini.sections["Fix Aspect Ratio"], "Enabled", bFixAspect);
+    spdlog::info("Config Parse: bFixAspect: {}", bFixAspect);
+
+    inipp::get_value(ini.sections["Fix HUD"], "Enabled", bFixHUD);
+    spdlog::info("Config Parse: bFixHUD: {}", bFixHUD);
+
+    inipp::get_value(ini.sections["Skip Intro"], "Enabled", bSkipIntro);
+    spdlog::info("Config Parse: bSkipIntro: {}", bSkipIntro);
+
+    float fMultiplier = fGameplayFOVMulti;
+    inipp::get_value(ini.sections["Gameplay FOV"], "Multiplier", fMultiplier);
+    if (fMultiplier < 0.10f || fMultiplier > 3.00f) {
+        fMultiplier = std::clamp(fMultiplier, 0.10f, 3.00f);
+        spdlog::warn("Config Parse: fGameplayFOVMulti value invalid, clamped to {}", fMultiplier);
+    }
+    fGameplayFOVMulti = fMultiplier;
+    spdlog::info("Config Parse: fGameplayFOVMulti: {}", fMultiplier);
+
+    inipp::get_value(ini.sections["Render Texture Resolution"], "Enabled", bRenderTextureRes);
+    spdlog::info("Config Parse: bRenderTextureRes: {}", bRenderTextureRes);
+
+    inipp::get_value(ini.sections["Framerate Cap"], "Framerate", iFramerateCap);
+    if (iFramerateCap < 10 || iFramerateCap > 500) {
+        iFramerateCap = std::clamp(iFramerateCap, 10, 500);
+        spdlog::warn("Config Parse: iFramerateCap value invalid, clamped to {}", iFramerateCap);
+    }
+    spdlog::info("Config Parse: iFramerateCap: {}", iFramerateCap);
+    bool bLimiter = bFrameLimiter;
+    int iStatsInterval = iFrameStatsInterval;
+    inipp::get_value(ini.sections["Framerate Cap"], "Limiter", bLimiter);
+    inipp::get_value(ini.sections["Framerate Cap"], "StatsInterval", iStatsInterval);
+    if (iStatsInterval < 0 || iStatsInterval > 3600) {
+        iStatsInterval = std::clamp(iStatsInterval, 0, 3600);
+        spdlog::warn("Config Parse: iFrameStatsInterval value invalid, clamped to {}", iStatsInterval);
+    }
+    bFrameLimiter = bLimiter;
+    iFrameStatsInterval = iStatsInterval;
+    spdlog::info("Config Parse: bFrameLimiter: {}", bLimiter);
+    spdlog::info("Config Parse: iFrameStatsInterval: {}", iStatsInterval);
+
+    inipp::get_value(ini.sections["Shadow Quality"], "Resolution", iShadowResolution);
+    if (iShadowResolution < 64 || iShadowResolution > 16384) {
+        iShadowResolution = std::clamp(iShadowResolution, 64, 16384);
+        spdlog::warn("Config Parse: iShadowResolution value invalid, clamped to {}", iShadowResolution);
+    }
+    spdlog::info("Config Parse: iShadowResolution: {}", iShadowResolution);
+}
+
 void Configuration()
 {
     // Initialise config
@@ -205,41 +230,31 @@ void Configuration()
     spdlog::info("Config Parse: iCustomResX: {}", iCustomResX);
     spdlog::info("Config Parse: iCustomResY: {}", iCustomResY);
 
-    inipp::get_value(ini.sections["Fix FOV"], "Enabled", bFixFOV);
-    spdlog::info("Config Parse: bFixFOV: {}", bFixFOV);
+    ParseConfig();
 
-    inipp::get_value(ini.sections["Fix Aspect Ratio"], "Enabled", bFixAspect);
-    spdlog::info("Config Parse: bFixAspect: {}", bFixAspect);
-
-    inipp::get_value(ini.sections["Fix HUD"], "Enabled", bFixHUD);
-    spdlog::info("Config Parse: bFixHUD: {}", bFixHUD);
-
-    inipp::get_value(ini.sections["Skip Intro"], "Enabled", bSkipIntro);
-    spdlog::info("Config Parse: bSkipIntro: {}", bSkipIntro);
-
-    inipp::get_value(ini.sections["Gameplay FOV"], "Multiplier", fGameplayFOVMulti);
-    if ((float)fGameplayFOVMulti < 0.10f || (float)fGameplayFOVMulti > 3.00f) {
-        fGameplayFOVMulti = std::clamp((float)fGameplayFOVMulti, 0.10f, 3.00f);
-        spdlog::warn("Config Parse: fGameplayFOVMulti value invalid, clamped to {}", fGameplayFOVMulti);
+    inipp::get_value(ini.sections["Profiling"], "Enabled", bProfiling);
+    inipp::get_value(ini.sections["Profiling"], "Interval", iProfilingInterval);
+    if (iProfilingInterval < 1 || iProfilingInterval > 3600) {
+        iProfilingInterval = std::clamp(iProfilingInterval, 1, 3600);
+        spdlog::warn("Config Parse: iProfilingInterval value invalid, clamped to {}", iProfilingInterval);
     }
-    spdlog::info("Config Parse: fGameplayFOVMulti: {}", fGameplayFOVMulti);
-
-    inipp::get_value(ini.sections["Render Texture Resolution"], "Enabled", bRenderTextureRes);
-    spdlog::info("Config Parse: bRenderTextureRes: {}", bRenderTextureRes);
-
-    inipp::get_value(ini.sections["Framerate Cap"], "Framerate", iFramerateCap);
-    if (iFramerateCap < 10 || iFramerateCap > 500) {
-        iFramerateCap = std::clamp(iFramerateCap, 10, 500);
-        spdlog::warn("Config Parse: iFramerateCap value invalid, clamped to {}", iFramerateCap);
+    spdlog::info("Config Parse: bProfiling: {}", bProfiling);
+    spdlog::info("Config Parse: iProfilingInterval: {}", iProfilingInterval);
+
+    inipp::get_value(ini.sections["Trace"], "Enabled", bTrace);
+    inipp::get_value(ini.sections["Trace"], "Hotkey", iTraceHotkey);
+    inipp::get_value(ini.sections["Trace"], "DumpAfter", iTraceDumpAfter);
+    if (iTraceHotkey < 0 || iTraceHotkey > 254) {
+        iTraceHotkey = 0;
+        spdlog::warn("Config Parse: iTraceHotkey value invalid, hotkey disabled");
     }
-    spdlog::info("Config Parse: iFramerateCap: {}", iFramerateCap);
-
-    inipp::get_value(ini.sections["Shadow Quality"], "Resolution", iShadowResolution);
-    if (iShadowResolution < 64 || iShadowResolution > 16384) {
-        iShadowResolution = std::clamp(iShadowResolution, 64, 16384);
-        spdlog::warn("Config Parse: iShadowResolution value invalid, clamped to {}", iShadowResolution);
+    if (iTraceDumpAfter < 0 || iTraceDumpAfter > 86400) {
+        iTraceDumpAfter = std::clamp(iTraceDumpAfter, 0, 86400);
+        spdlog::warn("Config Parse: iTraceDumpAfter value invalid, clamped to {}", iTraceDumpAfter);
     }
-    spdlog::info("Config Parse: iShadowResolution: {}", iShadowResolution);
+    spdlog::info("Config Parse: bTrace: {}", bTrace);
+    spdlog::info("Config Parse: iTraceHotkey: {}", iTraceHotkey);
+    spdlog::info("Config Parse: iTraceDumpAfter: {}", iTraceDumpAfter);
 
     spdlog::info("----------");
 
@@ -257,586 +272,513 @@ void Configuration()
     CalculateAspectRatio(true);
 }
 
-void Resolution()
+void ScanSignatures()
 {
-    uint8_t* CurrentResolutionScanResult = Memory::PatternScan(baseModule, "89 ?? ?? 89 ?? ?? 48 ?? ?? ?? 89 ?? ?? 89 ?? ?? 48 ?? ?? ?? 74 ?? FF ?? ?? ?? ?? ??");
-    if (CurrentResolutionScanResult) {
-        spdlog::info("Current Resolution: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)CurrentResolutionScanResult - (uintptr_t)baseModule);
-        static SafetyHookMid CurrentResolutionMidHook{};
-        CurrentResolutionMidHook = safetyhook::create_mid(CurrentResolutionScanResult,
-            [](SafetyHookContext& ctx) {
-                // Log resolution
-                int iResX = (int)ctx.rsi;
-                int iResY = (int)ctx.rdi;
-
-                if (iResX != iCurrentResX || iResY != iCurrentResY) {
-                    iCurrentResX = iResX;
-                    iCurrentResY = iResY;
-                    CalculateAspectRatio(true);
-                }
-            });
+    // Resolve every signature up front, before any hooks are installed
+    unsigned int workers = Scanner::DefaultWorkers();
+    auto scanStart = std::chrono::high_resolution_clock::now();
+
+    // Signatures cached for this build only need a compare at their old offset
+    auto pending = Memory::LoadSignatureCache(baseModule, sThisModulePath.string() + sCacheFile, Signatures);
+    spdlog::info("Signature Cache: Verified {}/{} cached signatures.", Signatures.size() - pending.size(), Signatures.size());
+
+    // The exe on disk doesn't depend on the game having finished unpacking or initializing, so it's scanned on another thread
+    // while the code index is built from memory. Deferred signatures are included so their watchers know where to look.
+    bool bUncached = !pending.empty();
+    auto onDisk = pending;
+    onDisk.insert(onDisk.end(), DeferredSignatures.begin(), DeferredSignatures.end());
+    auto diskScan = std::async(std::launch::async, [onDisk, workers] { return Memory::ScanFile(baseModule, sExePath / sExeName, onDisk, workers); });
+
+    auto indexStart = std::chrono::high_resolution_clock::now();
+    codeIndex = std::make_unique<Disasm::CodeIndex>(Pe::Image::FromModule(baseModule), false, workers);
+    auto indexTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - indexStart);
+
+    // Anything found on disk is only used if the same bytes are at the same RVA in memory
+    auto found = diskScan.get();
+    if (!pending.empty()) {
+        auto unverified = Memory::ApplyFileMatches(baseModule, pending, found);
+        spdlog::info("Signature Scan: Verified {}/{} signatures found in the exe on disk.", pending.size() - unverified.size(), pending.size());
+        pending = std::move(unverified);
     }
-    else if (!CurrentResolutionScanResult) {
-        spdlog::error("Current Resolution: Pattern scan failed.");
+    for (auto sig : DeferredSignatures) {
+        auto match = std::find_if(found.begin(), found.end(), [sig](const Memory::ImageMatch& match) { return match.signature == sig; });
+        if (match != found.end())
+            diskHints[sig] = (std::uint8_t*)baseModule + match->rva;
     }
 
-    // Add custom resolution
-    if (bCustomRes) {
-        // These patterns will always be valid but may not be in memory yet. 
-        // So we'll attempt to scan for it for 30 seconds and give the game time to load it.
-        uint8_t* ResolutionList1ScanResult = nullptr;
-        for (int attempts = 0; attempts < 300; ++attempts) {
-            if (ResolutionList1ScanResult = Memory::PatternScan(baseModule, "00 05 00 00 D0 02 00 00 56 05 00 00"))
-                break; // Exit loop
-            std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Sleep and check again
-        }
-        uint8_t* ResolutionList2ScanResult = Memory::PatternScan(baseModule, "00 05 D0 02 56 05 00 03 40 06");
-        if (ResolutionList1ScanResult && ResolutionList2ScanResult) {
-            spdlog::info("Custom Resolution: List 1: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)ResolutionList1ScanResult - (uintptr_t)baseModule);
-            spdlog::info("Custom Resolution: List 2: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)ResolutionList2ScanResult - (uintptr_t)baseModule);
-
-            // Replace 1280x720 with new resolution
-            Memory::Write((uintptr_t)ResolutionList1ScanResult, iCustomResX);
-            Memory::Write((uintptr_t)ResolutionList1ScanResult + 0x4, iCustomResY);
-            Memory::Write((uintptr_t)ResolutionList2ScanResult, (short)iCustomResX);
-            Memory::Write((uintptr_t)ResolutionList2ScanResult + 0x2, (short)iCustomResY);
-            spdlog::info("Custom Resolution: List: Replaced 1280x720 with {}x{}", iCustomResX, iCustomResY);
-        }
-        else if (!ResolutionList1ScanResult || !ResolutionList2ScanResult) {
-            spdlog::error("Custom Resolution: Pattern scan(s) failed.");
-        }
-
-        // Spoof GetSystemMetrics results so our custom resolution is always valid
-        uint8_t* SystemMetricsScanResult = Memory::PatternScan(baseModule, "89 ?? ?? ?? ?? ?? FF ?? ?? ?? ?? ?? 89 ?? ?? ?? ?? ?? 48 89 ?? ?? ?? ?? ?? ?? ?? ?? 48 89 ?? ?? 89 ?? ??");
-        uint8_t* ResCheckScanResult = Memory::PatternScan(baseModule, "74 ?? 3B ?? ?? 77 ?? 3B ?? 0F ?? ?? ?? ?? ?? FF ?? 48 ?? ?? ??");
-        if (SystemMetricsScanResult && ResCheckScanResult) {
-            spdlog::info("Custom Resolution: GetSystemMetrics: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)SystemMetricsScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid ReportedWidthMidHook{};
-            ReportedWidthMidHook = safetyhook::create_mid(SystemMetricsScanResult,
-                [](SafetyHookContext& ctx) {
-                    ctx.rax = iCustomResX;
-                });
-
-            static SafetyHookMid ReportedHeightMidHook{};
-            ReportedHeightMidHook = safetyhook::create_mid(SystemMetricsScanResult + 0xC,
-                [](SafetyHookContext& ctx) {
-                    ctx.rax = iCustomResY;
-                });
-
-            // Allow internal resolution that is higher than the output
-            spdlog::info("Custom Resolution: GetSystemMetrics: ResCheck: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)ResCheckScanResult - (uintptr_t)baseModule);
-            Memory::PatchBytes((uintptr_t)ResCheckScanResult, "\xE9\x89\x00\x00\x00", 5);
-            spdlog::info("Custom Resolution: GetSystemMetrics: ResCheck: Patched instruction.");
-        }
-        else if (!SystemMetricsScanResult || !ResCheckScanResult) {
-            spdlog::error("Custom Resolution: GetSystemMetrics: Pattern scan(s) failed.");
-        }
+    if (!pending.empty()) {
+        Memory::PatternScan(baseModule, pending, workers);
+        spdlog::info("Signature Scan: Scanned for {} signatures using {} scan kernel with {} worker thread(s).", pending.size(), Scanner::KernelName(Scanner::DetectKernel()), workers);
     }
-}
-
-void SkipIntro()
-{
-    if (bSkipIntro) {
-        // Opening State
-        uint8_t* OpeningStateScanResult = Memory::PatternScan(baseModule, "48 ?? ?? 83 ?? 0E 0F 87 ?? ?? ?? ?? 48 ?? ?? ?? ?? 48 ?? ?? ?? ?? ?? ??");
-        if (OpeningStateScanResult) {
-            spdlog::info("Intro Skip: Opening State: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)OpeningStateScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid OpeningStateMidHook{};
-            OpeningStateMidHook = safetyhook::create_mid(OpeningStateScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (ctx.rax == 0x04)
-                        ctx.rax = 0x0E;
-                });
-        }
-        else if (!OpeningStateScanResult) {
-            spdlog::error("Intro Skip: Opening State: Pattern scan failed.");
-        }
-    } 
-}
-
-void AspectFOV()
-{
-    if (bFixAspect) {
-        // Markers + Enemy Culling Aspect Ratio
-        uint8_t* CullingMarkersAspectScanResult = Memory::PatternScan(baseModule, "8B ?? ?? ?? ?? ?? 48 ?? ?? 89 ?? ?? ?? ?? ?? 66 ?? ?? ?? ?? ?? ?? 00 01");
-        if (CullingMarkersAspectScanResult) {
-            spdlog::info("Aspect Ratio: Markers/Culling: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)CullingMarkersAspectScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid CullingMarkersAspectMidHook{};
-            CullingMarkersAspectMidHook = safetyhook::create_mid(CullingMarkersAspectScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (ctx.rcx + 0x1B0) {
-                        if (fAspectRatio != fNativeAspect)
-                            *reinterpret_cast<float*>(ctx.rcx + 0x1B0) = fAspectRatio;
-                    }                
-                });
-        }
-        else if (!CullingMarkersAspectScanResult) {
-            spdlog::error("Aspect Ratio: Markers/Culling: Pattern scan failed.");
-        }
+    if (bUncached)
+        Memory::SaveSignatureCache(baseModule, sThisModulePath.string() + sCacheFile, Signatures);
+    auto scanTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - scanStart);
+
+    // A signature that matches more or fewer times than it should is probably hooking the wrong code now
+    for (auto sig : Signatures) {
+        auto outcome = sig->address ? fmt::format("using match {}", sig->index + 1) : "not using it";
+        if (sig->matches > sig->expected)
+            spdlog::warn("Signature Scan: {} is ambiguous, matched more than {} time(s), {}.", sig->name, sig->expected, outcome);
+        else if (sig->matches > 0 && sig->matches < sig->expected)
+            spdlog::warn("Signature Scan: {} matched {} time(s), expected {}, {}.", sig->name, sig->matches, sig->expected, outcome);
     }
 
-    if (fGameplayFOVMulti != 1.00f) {
-        // Gameplay FOV
-        uint8_t* GameplayFOVScanResult = Memory::PatternScan(baseModule, "F3 0F ?? ?? 78 ?? ?? ?? 0F ?? ?? F3 0F ?? ?? E8 ?? ?? ?? ?? 85 ?? 75 ?? F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ??");
-        if (GameplayFOVScanResult) {
-            spdlog::info("FOV: Gameplay: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)GameplayFOVScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid GameplayFOVMidHook{};
-            GameplayFOVMidHook = safetyhook::create_mid(GameplayFOVScanResult + 0x8,
-                [](SafetyHookContext& ctx) {
-                    ctx.xmm4.f32[0] *= fGameplayFOVMulti;
-                });
-        }
-        else if (!GameplayFOVScanResult) {
-            spdlog::error("FOV: Gameplay: Pattern scan failed.");
-        }
-    }
+    auto resolved = std::count_if(Signatures.begin(), Signatures.end(), [](const Memory::Signature* sig) { return sig->address != nullptr; });
+    spdlog::info("Signature Scan: Resolved {}/{} signatures in {:.3f}ms.", resolved, Signatures.size(), scanTime.count() / 1000.0);
 
-    if (bFixFOV) {
-        // Cutscene FOV
-        uint8_t* CutsceneFOVScanResult = Memory::PatternScan(baseModule, "00 0F 84 ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? 0F ?? ?? ?? ?? 0F ?? ?? ?? ?? 0F ?? ??");
-        if (CutsceneFOVScanResult) {
-            spdlog::info("FOV: Cutscene: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)CutsceneFOVScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid CutsceneFOVMidHook{};
-            CutsceneFOVMidHook = safetyhook::create_mid(CutsceneFOVScanResult + 0xF,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm0.f32[0] = fNativeAspect;
-                });
-        }
-        else if (!CutsceneFOVScanResult) {
-            spdlog::error("FOV: Cutscene: Pattern scan failed.");
-        }
-    }
+    spdlog::info("Code Index: Decoded {} instructions in {:.3f}ms.", codeIndex->InstructionCount(), indexTime.count() / 1000.0);
+    spdlog::info("----------");
 }
 
-void HUD()
+void Resolution()
 {
-    if (bFixHUD) {
-        // HUD Size
-        uint8_t* HUDSizeScanResult = Memory::PatternScan(baseModule, "45 ?? ?? 75 ?? 0F 28 ?? ?? ?? ?? ?? 0F ?? ?? F2 0F ?? ?? ?? ?? ?? ?? 33 ??");
-        if (HUDSizeScanResult) {
-            spdlog::info("HUD: Size: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)HUDSizeScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid HUDSizeMidHook{};
-            HUDSizeMidHook = safetyhook::create_mid(HUDSizeScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect) {
-                        ctx.xmm9.f32[0] *= 1920.00f;
-                        ctx.xmm9.f32[0] /= 1080.00f * fAspectRatio;
-                    }
-                    else if (fAspectRatio < fNativeAspect) {
-                        ctx.xmm7.f32[0] *= 1080.00f;
-                        ctx.xmm7.f32[0] /= 1920.00f / fAspectRatio;
-                    }
-                });
-        }
-        else if (!HUDSizeScanResult) {
-            spdlog::error("HUD: Size: Pattern scan failed.");
-        }
-
-        // Minimap Position
-        uint8_t* MinimapPositionScanResult = Memory::PatternScan(baseModule, "F3 0F ?? ?? ?? 0F ?? ?? 76 ?? F3 0F ?? ?? EB ?? F3 0F ?? ?? f3 0F ?? ?? 89 ?? ?? ?? 45 ?? ??");
-        if (MinimapPositionScanResult) {
-            spdlog::info("HUD: Minimap Position: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)MinimapPositionScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid MinimapPositionWidthMidHook{};
-            MinimapPositionWidthMidHook = safetyhook::create_mid(MinimapPositionScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm0.f32[0] = 1080.00f * fAspectRatio;
-                });
-
-            static SafetyHookMid MinimapPositionHeightMidHook{};
-            MinimapPositionHeightMidHook = safetyhook::create_mid(MinimapPositionScanResult + 0x2C,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio < fNativeAspect)
-                        ctx.xmm0.f32[0] = 1920.00f / fAspectRatio;
-                });
-        }
-        else if (!MinimapPositionScanResult) {
-            spdlog::error("HUD: Minimap Position: Pattern scan failed.");
-        }
-
-        // Key Guides
-        uint8_t* KeyGuide1ScanResult = Memory::PatternScan(baseModule, "F3 0F ?? ?? ?? ?? ?? ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? E8 ?? ?? ?? ??");
-        uint8_t* KeyGuide2ScanResult = Memory::PatternScan(baseModule, "0F ?? ?? 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ??");
-        uint8_t* KeyGuide3ScanResult = Memory::PatternScan(baseModule, "F3 0F ?? ?? ?? ?? ?? ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? 48 8B ?? ?? ??");
-        if (KeyGuide1ScanResult && KeyGuide2ScanResult && KeyGuide3ScanResult) {
-            spdlog::info("HUD: Key Guide: 1: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)KeyGuide1ScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid KeyGuide1MidHook{};
-            KeyGuide1MidHook = safetyhook::create_mid(KeyGuide1ScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm4.f32[0] = fHUDWidth;
-                });
-
-            spdlog::info("HUD: Key Guide: 2: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)KeyGuide2ScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid KeyGuide2MidHook{};
-            KeyGuide2MidHook = safetyhook::create_mid(KeyGuide2ScanResult + 0x6,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm4.f32[0] = fHUDWidth;
-                });
-
-            spdlog::info("HUD: Key Guide: 3: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)KeyGuide3ScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid KeyGuide3MidHook{};
-            KeyGuide3MidHook = safetyhook::create_mid(KeyGuide3ScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm4.f32[0] = fHUDWidth;
-                });
-        }
-        else if (!KeyGuide1ScanResult || !KeyGuide2ScanResult || !KeyGuide3ScanResult) {
-            spdlog::error("HUD: Key Guide: Pattern scan(s) failed.");
-        }
-
-        // Button Height
-        uint8_t* ButtonHeight1ScanResult = Memory::PatternScan(baseModule, "F3 0F ?? ?? ?? ?? ?? ?? 0F 28 ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 44 ?? ?? ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ??");
-        uint8_t* ButtonHeight2ScanResult = Memory::PatternScan(baseModule, "F3 0F ?? ?? ?? ?? ?? ?? 0F 28 ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 44 ?? ?? ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? 44 ?? ?? ?? ?? ?? ??");
-        if (ButtonHeight1ScanResult && ButtonHeight2ScanResult) {
-            spdlog::info("HUD: Button Height: 1: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)ButtonHeight1ScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid ButtonHeight1MidHook{};
-            ButtonHeight1MidHook = safetyhook::create_mid(ButtonHeight1ScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio < fNativeAspect)
-                        ctx.xmm2.f32[0] = fHUDHeight;
-                });
-
-            spdlog::info("HUD: Button Height: 2: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)ButtonHeight2ScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid ButtonHeight2MidHook{};
-            ButtonHeight2MidHook = safetyhook::create_mid(ButtonHeight2ScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio < fNativeAspect)
-                        ctx.xmm2.f32[0] = fHUDHeight;
-                });
-        }
-        else if (!ButtonHeight1ScanResult || !ButtonHeight2ScanResult) {
-            spdlog::error("HUD: Button Height: Pattern scan(s) failed.");
-        }
-
-        // Menu Selections
-        uint8_t* MenuSelectionsScanResult = Memory::PatternScan(baseModule, "F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? 83 ?? ?? 7C ?? F3 0F ?? ?? ?? ?? ?? ?? EB ??");
-        if (MenuSelectionsScanResult) {
-            spdlog::info("HUD: Menu Selections: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)MenuSelectionsScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid MenuSelectionsMidHook{};
-            MenuSelectionsMidHook = safetyhook::create_mid(MenuSelectionsScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm1.f32[0] = fHUDWidth;
-                });
-        }
-        else if (!MenuSelectionsScanResult) {
-            spdlog::error("HUD: Menu Selections: Pattern scan failed.");
-        }
-
-        // Minimap Icons
-        uint8_t* MinimapIconsScanResult = Memory::PatternScan(baseModule, "F3 41 ?? ?? ?? ?? F3 41 ?? ?? ?? ?? F3 44 ?? ?? ?? F3 44 ?? ?? ?? 0F ?? ?? ?? 0F 83 ?? ?? ?? ??");
-        if (MinimapIconsScanResult) {
-            spdlog::info("HUD: Minimap Icons: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)MinimapIconsScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid MinimapIconsMidHook{};
-            MinimapIconsMidHook = safetyhook::create_mid(MinimapIconsScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect) {
-                        ctx.xmm1.f32[0] *= 1920.00f;
-                        ctx.xmm1.f32[0] /= 1080.00f * fAspectRatio;
-                    }
-                    else if (fAspectRatio < fNativeAspect) {
-                        ctx.xmm0.f32[0] *= 1080.00f;
-                        ctx.xmm0.f32[0] /= 1920.00f / fAspectRatio;
-                    }
-                });
-        }
-        else if (!MinimapIconsScanResult) {
-            spdlog::error("HUD: Minimap Icons: Pattern scan failed.");
-        }
-
-        // Gameplay HUD
-        uint8_t* GameplayHUDScanResult = Memory::PatternScan(baseModule, "F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? 66 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? F3 0F ?? ?? ?? ?? F3 0F ?? ??");
-        if (GameplayHUDScanResult) {
-            spdlog::info("HUD: Gameplay HUD: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)GameplayHUDScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid GameplayHUDWidthMidHook{};
-            GameplayHUDWidthMidHook = safetyhook::create_mid(GameplayHUDScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm1.f32[0] = fHUDWidth;
-                });
-
-            static SafetyHookMid GameplayHUDHeightMidHook{};
-            GameplayHUDHeightMidHook = safetyhook::create_mid(GameplayHUDScanResult + 0x17,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio < fNativeAspect)
-                        ctx.xmm0.f32[0] = fHUDHeight;
-                });
-        }
-        else if (!GameplayHUDScanResult) {
-            spdlog::error("HUD: Gameplay HUD: Pattern scan failed.");
-        }
-
-        // Get movie state
-        uint8_t* MovieStateScanResult = Memory::PatternScan(baseModule, "4C ?? ?? 83 ?? 16 0F 87 ?? ?? ?? ?? 48 8D ?? ?? ?? ?? ??");
-        if (MovieStateScanResult) {
-            spdlog::info("HUD: Movie State: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)MovieStateScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid MovieStateMidHook{};
-            MovieStateMidHook = safetyhook::create_mid(MovieStateScanResult,
-                [](SafetyHookContext& ctx) {
-                    // Is movie playing/paused
-                    if ((int)ctx.rax == 0x0B || (int)ctx.rax == 0x0C || (int)ctx.rax == 0x0D || (int)ctx.rax == 0x0F || (int)ctx.rax == 0x10) {
-                        bIsMoviePlaying = true;
-                    }
-                    else {
-                        bIsMoviePlaying = false;
-                    }
-                });
-        }
-        else if (!MovieStateScanResult) {
-            spdlog::error("HUD: Movie State: Pattern scan failed.");
-        }
-
-        // Fades + Movies
-        uint8_t* FadesScanResult = Memory::PatternScan(baseModule, "8B ?? ?? ?? ?? 00 89 ?? ?? 49 ?? ?? ?? 48 ?? ?? FF ?? ?? ?? ?? 00");
-        if (FadesScanResult) {
-            spdlog::info("HUD: Fades: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)FadesScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid FadesMidHook{};
-            FadesMidHook = safetyhook::create_mid(FadesScanResult,
-                [](SafetyHookContext& ctx)
-                {
-                    if (ctx.rax + 0xF0) {
-                        // Check for fade to black (2689x1793)
-                        if (*reinterpret_cast<short*>(ctx.rax + 0xF0) == (short)2689 && *reinterpret_cast<short*>(ctx.rax + 0xF2) == (short)1793) {
-                            if (fAspectRatio > fNativeAspect) {
-                                *reinterpret_cast<short*>(ctx.rax + 0xF0) = static_cast<int>(1793 * fAspectRatio); // Set new width
-                            }
-                            else if (fAspectRatio < fNativeAspect) {
-                                *reinterpret_cast<short*>(ctx.rax + 0xF2) = static_cast<int>(2689 / fAspectRatio); // Set new height
-                            }
-                        }
-
-                        // Fix movies
-                        char* sElementName = (char*)ctx.rax + 0x280;
-                        if (strcmp(sElementName, "ktglkids_scl_capture_plane_full_rgba8") == 0) {
-                            if (bIsMoviePlaying) {
-                                if (fAspectRatio > fNativeAspect) {
-                                    *reinterpret_cast<short*>(ctx.rax + 0xF0) = static_cast<short>(std::round(fHUDWidth));
-                                }
-                                else if (fAspectRatio < fNativeAspect) {
-                                    *reinterpret_cast<short*>(ctx.rax + 0xF2) = static_cast<short>(std::round(fHUDHeight));
-                                }
-                            }
-                            else if (!bIsMoviePlaying) {
-                                if (fAspectRatio > fNativeAspect) {
-                                    *reinterpret_cast<short*>(ctx.rax + 0xF0) = (short)iCurrentResX;
-                                }
-                                else if (fAspectRatio < fNativeAspect) {
-                                    *reinterpret_cast<short*>(ctx.rax + 0xF2) = (short)iCurrentResY;
-                                }
-                            }
-                        }
-                    }
-                });
-        }
-        else if (!FadesScanResult) {
-            spdlog::error("HUD: Fades: Pattern scan failed.");
-        }
+    // Add custom resolution
+    if (bCustomRes) {
+        // Both lists will always be valid but may not be in memory yet.
+        // So we'll watch for them for 30 seconds in the background instead of holding up the remaining hooks, the second once the first shows up.
+        // Hints are looked up here since the watchers run on their own threads.
+        auto list1Hint = diskHints.contains(&ResolutionList1Sig) ? diskHints.at(&ResolutionList1Sig) : nullptr;
+        auto list2Hint = diskHints.contains(&ResolutionList2Sig) ? diskHints.at(&ResolutionList2Sig) : nullptr;
+        Memory::WatchSignature(baseModule, ResolutionList1Sig,
+            [list2Hint](std::uint8_t* ResolutionList1ScanResult) {
+                if (!ResolutionList1ScanResult) {
+                    spdlog::error("Custom Resolution: List 1: Pattern scan failed.");
+                    return;
+                }
+                spdlog::info("Custom Resolution: List 1: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)ResolutionList1ScanResult - (uintptr_t)baseModule);
 
-        // Screen size
-        uint8_t* ScreenSizeScanResult = Memory::PatternScan(baseModule, "41 ?? ?? ?? 80 ?? ?? ?? 00 41 ?? 01 00 00 00 F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ??");
-        if (ScreenSizeScanResult) {
-            spdlog::info("HUD: Screen Size: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)ScreenSizeScanResult - (uintptr_t)baseModule);
-
-            static SafetyHookMid ScreenSizeMidHook{};
-            ScreenSizeMidHook = safetyhook::create_mid(ScreenSizeScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (ctx.r8 + 0x60) {
-                        if (*reinterpret_cast<short*>(ctx.r8 + 0x60) == (short)1920 && *reinterpret_cast<short*>(ctx.r8 + 0x62) == (short)1080) {
-                            if (fAspectRatio > fNativeAspect) {
-                                *reinterpret_cast<short*>(ctx.r8 + 0x60) = static_cast<short>(1080.00f * fAspectRatio);
-                            }
-                            else if (fAspectRatio < fNativeAspect) {
-                                *reinterpret_cast<short*>(ctx.r8 + 0x62) = static_cast<short>(1920.00f / fAspectRatio);
-                            }
+                Memory::WatchSignature(baseModule, ResolutionList2Sig,
+                    [ResolutionList1ScanResult](std::uint8_t* ResolutionList2ScanResult) {
+                        if (!ResolutionList2ScanResult) {
+                            spdlog::error("Custom Resolution: List 2: Pattern scan failed.");
+                            return;
                         }
-                    }
-                });
-        }
-        else if (!ScreenSizeScanResult) {
-            spdlog::error("HUD: Screen Size: Pattern scan failed.");
-        }
-
-        // Growth Map
-        uint8_t* GrowthMapScanResult = Memory::PatternScan(baseModule, "F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? 66 ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? 66 0F ?? ?? ?? ?? ?? ??");
-        if (GrowthMapScanResult) {
-            spdlog::info("HUD: Growth Map: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)GrowthMapScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid GrowthMapWidthMidHook{};
-            GrowthMapWidthMidHook = safetyhook::create_mid(GrowthMapScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm0.f32[0] = fHUDWidth;
-                });
-
-            static SafetyHookMid GrowthMapHeightMidHook{};
-            GrowthMapHeightMidHook = safetyhook::create_mid(GrowthMapScanResult + 0x32,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio < fNativeAspect)
-                        ctx.xmm0.f32[0] = fHUDHeight;
-                });
-        }
-        else if (!GrowthMapScanResult) {
-            spdlog::error("HUD: Growth Map: Pattern scan failed.");
-        }
-
-        // Soul Map
-        uint8_t* SoulMapScanResult = Memory::PatternScan(baseModule, "F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? 66 ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? 66 0F ?? ?? ?? ?? ?? ??");
-        if (SoulMapScanResult) {
-            spdlog::info("HUD: Soul Map: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)SoulMapScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid SoulMapWidthMidHook{};
-            SoulMapWidthMidHook = safetyhook::create_mid(SoulMapScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm0.f32[0] = fHUDWidth;
-                });
-
-            static SafetyHookMid SoulMapHeightMidHook{};
-            SoulMapHeightMidHook = safetyhook::create_mid(SoulMapScanResult + 0x32,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio < fNativeAspect)
-                        ctx.xmm0.f32[0] = fHUDHeight;
-                });
-        }
-        else if (!SoulMapScanResult) {
-            spdlog::error("HUD: Soul Map: Pattern scan failed.");
-        }
-
-        // Mission Select
-        uint8_t* MissionSelect1ScanResult = Memory::PatternScan(baseModule, "F3 0F ?? ?? F3 41 ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? ?? ?? F3 0F ?? ?? ?? ?? 0F 28 ?? ?? ??");
-        uint8_t* MissionSelect2ScanResult = Memory::PatternScan(baseModule, "0F ?? ?? F3 41 ?? ?? ?? 66 0F ?? ?? 41 0F ?? ?? ?? 0F ?? ?? F3 0F ?? ?? F3 0F ?? ??");
-        if (MissionSelect1ScanResult && MissionSelect2ScanResult) {
-            spdlog::info("HUD: Mission Select: 1: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)MissionSelect1ScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid MissionSelect1SizeMidHook{};
-            MissionSelect1SizeMidHook = safetyhook::create_mid(MissionSelect1ScanResult,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm0.f32[0] = fHUDWidth;
-                });
-
-            static SafetyHookMid MissionSelect1OffsetMidHook{};
-            MissionSelect1OffsetMidHook = safetyhook::create_mid(MissionSelect1ScanResult - 0x1E,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm0.f32[0] += ((1080.00f * fAspectRatio) - 1920.00f) / 2.00f;
-                });
-
-            spdlog::info("HUD: Mission Select: 2: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)MissionSelect2ScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid MissionSelect2SizeMidHook{};
-            MissionSelect2SizeMidHook = safetyhook::create_mid(MissionSelect2ScanResult + 0x3,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm2.f32[0] = fHUDWidth;
-                    if (fAspectRatio < fNativeAspect)
-                        ctx.xmm3.f32[0] = fHUDHeight;
-                });
-
-            static SafetyHookMid MissionSelect2OffsetWidthMidHook{};
-            MissionSelect2OffsetWidthMidHook = safetyhook::create_mid(MissionSelect2ScanResult + 0x23,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio > fNativeAspect)
-                        ctx.xmm0.f32[0] += ((1080.00f * fAspectRatio) - 1920.00f) / 2.00f;
-                });
-
-            static SafetyHookMid MissionSelect2OffsetHeightMidHook{};
-            MissionSelect2OffsetHeightMidHook = safetyhook::create_mid(MissionSelect2ScanResult + 0x14,
-                [](SafetyHookContext& ctx) {
-                    if (fAspectRatio < fNativeAspect)
-                        ctx.xmm0.f32[0] += ((1920.00f / fAspectRatio) - 1080.00f) / 2.00f;
-                });
+                        spdlog::info("Custom Resolution: List 2: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)ResolutionList2ScanResult - (uintptr_t)baseModule);
+
+                        // Replace 1280x720 with new resolution
+                        bool bPatched = resolutionListPatch
+                            .Write((uintptr_t)ResolutionList1ScanResult, iCustomResX)
+                            .Write((uintptr_t)ResolutionList1ScanResult + 0x4, iCustomResY)
+                            .Write((uintptr_t)ResolutionList2ScanResult, (short)iCustomResX)
+                            .Write((uintptr_t)ResolutionList2ScanResult + 0x2, (short)iCustomResY)
+                            .Commit();
+                        if (bPatched)
+                            spdlog::info("Custom Resolution: List: Replaced 1280x720 with {}x{}", iCustomResX, iCustomResY);
+                        else
+                            spdlog::error("Custom Resolution: List: Failed to replace 1280x720.");
+                    }, list2Hint);
+            }, list1Hint);
+
+        // Allow internal resolution that is higher than the output
+        // The GetSystemMetrics spoof that goes with this is in the hook table
+        uint8_t* SystemMetricsScanResult = SystemMetricsSig.address;
+        uint8_t* ResCheckScanResult = ResCheckSig.address;
+        if (SystemMetricsScanResult && ResCheckScanResult) {
+            spdlog::info("Custom Resolution: GetSystemMetrics: ResCheck: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)ResCheckScanResult - (uintptr_t)baseModule);
+            if (resCheckPatch.Bytes((uintptr_t)ResCheckScanResult, "\xE9\x89\x00\x00\x00", 5).Commit())
+                spdlog::info("Custom Resolution: GetSystemMetrics: ResCheck: Patched instruction.");
+            else
+                spdlog::error("Custom Resolution: GetSystemMetrics: ResCheck: Failed to patch instruction.");
         }
-        else if (!MissionSelect1ScanResult || !MissionSelect2ScanResult) {
-            spdlog::error("HUD: Mission Select: Pattern scan(s) failed.");
+        else if (!SystemMetricsScanResult || !ResCheckScanResult) {
+            spdlog::error("Custom Resolution: GetSystemMetrics: Pattern scan(s) failed.");
         }
     }
 }
 
+// Safe to call again after a config reload
 void Framerate()
 {
-    if (iFramerateCap != 60) {
+    // The game's own cap is a "mov eax, 60", only touch it if it differs from what we want
+    if (FramerateCapSig.address ? *reinterpret_cast<int*>(FramerateCapSig.address + 0x1) != iFramerateCap : iFramerateCap != 60) {
         // Framerate Cap
-        uint8_t* FramerateCapScanResult = Memory::PatternScan(baseModule, "B8 3C 00 00 00 83 ?? 02 0F ?? ?? 8D ?? ?? 85 ?? 74 ?? 85 ??");
+        uint8_t* FramerateCapScanResult = FramerateCapSig.address;
         if (FramerateCapScanResult)
         {
             spdlog::info("Framerate Cap: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)FramerateCapScanResult - (uintptr_t)baseModule);
-            Memory::Write((uintptr_t)FramerateCapScanResult + 0x1, iFramerateCap);
-            spdlog::info("Framerate Cap: Patched instruction.");
+            // Back to the game's own value first so reloads don't stack up patches
+            framerateCapPatch.Revert();
+            if (framerateCapPatch.Write((uintptr_t)FramerateCapScanResult + 0x1, iFramerateCap).Commit())
+                spdlog::info("Framerate Cap: Patched instruction.");
+            else
+                spdlog::error("Framerate Cap: Failed to patch instruction.");
         }
         else if (!FramerateCapScanResult)
         {
             spdlog::error("Framerate Cap: Pattern scan failed.");
         }
     }
+
+    if ((bFrameLimiter || bTrace) && FramerateCapSig.address) {
+        // Frame Limiter
+        // Paces frames at the cap with the fix's own timer, see the "Framerate Cap: Frame" hook
+        // Tracing uses the same hook to mark frame boundaries, without the limiter it only measures
+        // Once created it's never replaced, the hook may be using it
+        if (!frameLimiter)
+            frameLimiter = std::make_unique<Pacing::Limiter<Pacing::WaitableTimerClock>>(0);
+        frameLimiter->SetTarget(bFrameLimiter ? iFramerateCap : 0);
+        if (bFrameLimiter)
+            spdlog::info("Framerate Cap: Limiter: Pacing at {}fps using a {} resolution timer.", iFramerateCap, frameLimiter->GetClock().HighResolution() ? "high" : "standard");
+    }
 }
 
+// Safe to call again after a config reload
 void Misc()
 {
+    // Start from the game's own values so a reload replaces the patch instead of stacking on it
+    shadowQualityPatch.Revert();
+
     if (iShadowResolution != 0)
     {
         // Shadow Quality
         // Changes "high" quality shadow resolution
-        uint8_t* ShadowQuality1ScanResult = Memory::PatternScan(baseModule, "00 10 00 00 00 10 00 00 4E 00 00 00 00 04 00 00");
-        uint8_t* ShadowQuality2ScanResult = Memory::PatternScan(baseModule, "BA 00 10 00 00 44 ?? ?? EB ?? BA 00 08 00 00");
+        uint8_t* ShadowQuality1ScanResult = ShadowQuality1Sig.address;
+        uint8_t* ShadowQuality2ScanResult = ShadowQuality2Sig.address;
         if (ShadowQuality1ScanResult && ShadowQuality2ScanResult)
         {
             spdlog::info("Shadow Quality: Address 1 is {:s}+{:x}", sExeName.c_str(), (uintptr_t)ShadowQuality1ScanResult - (uintptr_t)baseModule);
             spdlog::info("Shadow Quality: Address 2 is {:s}+{:x}", sExeName.c_str(), (uintptr_t)ShadowQuality2ScanResult - (uintptr_t)baseModule);
 
-            Memory::Write((uintptr_t)ShadowQuality1ScanResult, iShadowResolution);
-            Memory::Write((uintptr_t)ShadowQuality1ScanResult + 0x4, iShadowResolution);
-            Memory::Write((uintptr_t)ShadowQuality2ScanResult + 0x1, iShadowResolution);
+            bool bPatched = shadowQualityPatch
+                .Write((uintptr_t)ShadowQuality1ScanResult, iShadowResolution)
+                .Write((uintptr_t)ShadowQuality1ScanResult + 0x4, iShadowResolution)
+                .Write((uintptr_t)ShadowQuality2ScanResult + 0x1, iShadowResolution)
+                .Commit();
+            if (!bPatched)
+                spdlog::error("Shadow Quality: Failed to patch shadow resolution.");
         }
         else if (!ShadowQuality1ScanResult || !ShadowQuality2ScanResult)
         {
             spdlog::error("Shadow Quality: Pattern scan failed.");
         }
     }
+}
+
+// Hooks
+// Name, group, signature, offset from signature, enabled, callback, registers the callback reads or writes
+// Only the listed registers (plus the volatile ones) are saved around the callback, the rest of ctx is left uninitialized.
+namespace Reg = safetyhook::reg;
+Hooks::MidHook MidHooks[] = {
+    // Resolution
+    { "Current Resolution", "Current Resolution", &CurrentResolutionSig, 0x0, [] { return true; },
+        [](SafetyHookContext& ctx) {
+            // Log resolution
+            int iResX = (int)ctx.rsi;
+            int iResY = (int)ctx.rdi;
+
+            if (iResX != iCurrentResX || iResY != iCurrentResY) {
+                iCurrentResX = iResX;
+                iCurrentResY = iResY;
+                CalculateAspectRatio(true);
+            }
+        }, Reg::rsi | Reg::rdi },
+    // Spoof GetSystemMetrics results so our custom resolution is always valid
+    { "Custom Resolution: GetSystemMetrics: Width", "Custom Resolution: GetSystemMetrics", &SystemMetricsSig, 0x0, [] { return bCustomRes && ResCheckSig.address; },
+        [](SafetyHookContext& ctx) {
+            ctx.rax = iCustomResX;
+        }, Reg::rax },
+    { "Custom Resolution: GetSystemMetrics: Height", "Custom Resolution: GetSystemMetrics", &SystemMetricsSig, 0xC, [] { return bCustomRes && ResCheckSig.address; },
+        [](SafetyHookContext& ctx) {
+            ctx.rax = iCustomResY;
+        }, Reg::rax },
+
+    // Intro skip
+    { "Intro Skip: Opening State", "Intro Skip: Opening State", &OpeningStateSig, 0x0, [] { return bSkipIntro; },
+        [](SafetyHookContext& ctx) {
+            if (ctx.rax == 0x04)
+                ctx.rax = 0x0E;
+        }, Reg::rax },
+
+    // Frame limiter + trace frame boundary, runs once a frame where the game applies its own cap
+    // Placed after the "mov eax, 60" so the cap can still be re-patched in place, see Framerate()
+    { "Framerate Cap: Frame", "Framerate Cap", &FramerateCapSig, 0x5, [] { return frameLimiter != nullptr; },
+        [](SafetyHookContext& ctx) {
+            auto frametime = frameLimiter->Wait();
+            if (bTrace)
+                Trace::Frame(frameLimiter->GetClock().Now());
+            if (frametime <= 0)
+                return;
+            fCurrentFrametime = (float)(frametime / 1e9);
+
+            if (bFrameLimiter && iFrameStatsInterval > 0) {
+                static int64_t lastSummary = frameLimiter->GetClock().Now();
+                frameStats.Record(frametime);
+
+                auto now = frameLimiter->GetClock().Now();
+                if (now - lastSummary >= iFrameStatsInterval * 1000000000ll) {
+                    auto stats = frameStats.Compute();
+                    spdlog::info("Framerate Cap: Limiter: {:.1f}fps ({:.2f}ms) average, 1% low {:.1f}fps, 0.1% low {:.1f}fps, jitter {:.2f}ms over {} frames.",
+                        stats.averageFps, stats.averageMs, stats.low1Fps, stats.low01Fps, stats.jitterMs, stats.frames);
+                    frameStats.Reset();
+                    lastSummary = now;
+                }
+            }
+        }, Reg::none },
+
+    // Markers + Enemy Culling Aspect Ratio
+    { "Aspect Ratio: Markers/Culling", "Aspect Ratio: Markers/Culling", &CullingMarkersAspectSig, 0x0, [] { return bFixAspect; },
+        Hooks::ForModes([](auto, SafetyHookContext& ctx) {
+            auto layout = Layout::Current();
+            if (ctx.rcx + 0x1B0)
+                *reinterpret_cast<float*>(ctx.rcx + 0x1B0) = layout.aspectRatio;
+        }), Reg::rcx },
+    // Gameplay FOV
+    { "FOV: Gameplay", "FOV: Gameplay", &GameplayFOVSig, 0x8, [] { return fGameplayFOVMulti != 1.00f; },
+        [](SafetyHookContext& ctx) {
+            ctx.xmm4.f32[0] *= fGameplayFOVMulti;
+        }, Reg::xmm4 },
+    // Cutscene FOV
+    { "FOV: Cutscene", "FOV: Cutscene", &CutsceneFOVSig, 0xF, [] { return bFixFOV; },
+        Hooks::WiderConstant<0>([](const Layout::Snapshot&) { return fNativeAspect; }), Reg::xmm0 },
+
+    // HUD Size
+    { "HUD: Size", "HUD: Size", &HUDSizeSig, 0x0, [] { return bFixHUD; },
+        Hooks::ForModes([](auto mode, SafetyHookContext& ctx) {
+            auto layout = Layout::Current();
+            if constexpr (mode == Layout::Mode::Wider)
+                ctx.xmm9.f32[0] *= layout.widthScale;
+            else
+                ctx.xmm7.f32[0] *= layout.heightScale;
+        }), Reg::xmm7 | Reg::xmm9 },
+    // Minimap Position
+    { "HUD: Minimap Position: Width", "HUD: Minimap Position", &MinimapPositionSig, 0x0, [] { return bFixHUD; },
+        Hooks::WiderConstant<0>([](const Layout::Snapshot& layout) { return layout.scaledWidth; }), Reg::xmm0 },
+    { "HUD: Minimap Position: Height", "HUD: Minimap Position", &MinimapPositionSig, 0x2C, [] { return bFixHUD; },
+        Hooks::NarrowerConstant<0>([](const Layout::Snapshot& layout) { return layout.scaledHeight; }), Reg::xmm0 },
+    // Key Guides
+    { "HUD: Key Guide: 1", "HUD: Key Guide", &KeyGuide1Sig, 0x0, [] { return bFixHUD; },
+        Hooks::WiderConstant<4>([](const Layout::Snapshot& layout) { return layout.hudWidth; }), Reg::xmm4 },
+    { "HUD: Key Guide: 2", "HUD: Key Guide", &KeyGuide2Sig, 0x6, [] { return bFixHUD; },
+        Hooks::WiderConstant<4>([](const Layout::Snapshot& layout) { return layout.hudWidth; }), Reg::xmm4 },
+    { "HUD: Key Guide: 3", "HUD: Key Guide", &KeyGuide3Sig, 0x0, [] { return bFixHUD; },
+        Hooks::WiderConstant<4>([](const Layout::Snapshot& layout) { return layout.hudWidth; }), Reg::xmm4 },
+    // Button Height
+    { "HUD: Button Height: 1", "HUD: Button Height", &ButtonHeight1Sig, 0x0, [] { return bFixHUD; },
+        Hooks::NarrowerConstant<2>([](const Layout::Snapshot& layout) { return layout.hudHeight; }), Reg::xmm2 },
+    { "HUD: Button Height: 2", "HUD: Button Height", &ButtonHeight2Sig, 0x0, [] { return bFixHUD; },
+        Hooks::NarrowerConstant<2>([](const Layout::Snapshot& layout) { return layout.hudHeight; }), Reg::xmm2 },
+    // Menu Selections
+    { "HUD: Menu Selections", "HUD: Menu Selections", &MenuSelectionsSig, 0x0, [] { return bFixHUD; },
+        Hooks::WiderConstant<1>([](const Layout::Snapshot& layout) { return layout.hudWidth; }), Reg::xmm1 },
+    // Minimap Icons
+    { "HUD: Minimap Icons", "HUD: Minimap Icons", &MinimapIconsSig, 0x0, [] { return bFixHUD; },
+        Hooks::ForModes([](auto mode, SafetyHookContext& ctx) {
+            auto layout = Layout::Current();
+            if constexpr (mode == Layout::Mode::Wider)
+                ctx.xmm1.f32[0] *= layout.widthScale;
+            else
+                ctx.xmm0.f32[0] *= layout.heightScale;
+        }), Reg::xmm0 | Reg::xmm1 },
+    // Gameplay HUD
+    { "HUD: Gameplay HUD: Width", "HUD: Gameplay HUD", &GameplayHUDSig, 0x0, [] { return bFixHUD; },
+        Hooks::WiderConstant<1>([](const Layout::Snapshot& layout) { return layout.hudWidth; }), Reg::xmm1 },
+    { "HUD: Gameplay HUD: Height", "HUD: Gameplay HUD", &GameplayHUDSig, 0x17, [] { return bFixHUD; },
+        Hooks::NarrowerConstant<0>([](const Layout::Snapshot& layout) { return layout.hudHeight; }), Reg::xmm0 },
+    // Get movie state
+    { "HUD: Movie State", "HUD: Movie State", &MovieStateSig, 0x0, [] { return bFixHUD; },
+        [](SafetyHookContext& ctx) {
+            // Is movie playing/paused
+            if ((int)ctx.rax == 0x0B || (int)ctx.rax == 0x0C || (int)ctx.rax == 0x0D || (int)ctx.rax == 0x0F || (int)ctx.rax == 0x10) {
+                bIsMoviePlaying = true;
+            }
+            else {
+                bIsMoviePlaying = false;
+            }
+        }, Reg::rax },
+    // Fades + Movies
+    { "HUD: Fades", "HUD: Fades", &FadesSig, 0x0, [] { return bFixHUD; },
+        Hooks::ForModes([](auto mode, SafetyHookContext& ctx) {
+            auto layout = Layout::Current();
+            auto element = ctx.rax;
+            if (element + Elements::SizeOffset) {
+                // Check for fade to black (2689x1793)
+                if (Elements::GetSize(element) == Elements::FadeSize) {
+                    if constexpr (mode == Layout::Mode::Wider)
+                        Elements::SetSize(element, Elements::PackSize(static_cast<int>(layout.fadeWidth), 1793)); // Set new width
+                    else
+                        Elements::SetSize(element, Elements::PackSize(2689, static_cast<int>(layout.fadeHeight))); // Set new height
+                }
 
-    if (bRenderTextureRes) {
-        // Render Textures
-        uint8_t* RenderTextures1ScanResult = Memory::PatternScan(baseModule, "45 ?? ?? 44 ?? ?? ?? 41 0F ?? ?? 45 ?? ?? 75 ?? 44 ?? ?? ?? ?? ?? ?? EB ??");
-        uint8_t* RenderTextures2ScanResult = Memory::PatternScan(baseModule, "45 ?? ?? 44 ?? ?? ?? ?? 4C ?? ?? ?? 49 ?? ?? 44 ?? ?? ?? ??");
-        if (RenderTextures1ScanResult && RenderTextures2ScanResult) {
-            // Set 1920x1080 render textures to native resolution
-            spdlog::info("HUD: Render Textures: 1: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)RenderTextures1ScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid RenderTextures1MidHook{};
-            RenderTextures1MidHook = safetyhook::create_mid(RenderTextures1ScanResult,
-                [](SafetyHookContext& ctx) {
-                    if ((int)ctx.r10 == 1920 && (int)ctx.r11 == 1080) {
-                        ctx.r10 = iCurrentResX;
-                        ctx.r11 = iCurrentResY;
+                // Fix movies
+                if (Elements::Classify(element) == Elements::Kind::CapturePlane) {
+                    auto size = Elements::GetSize(element);
+                    if constexpr (mode == Layout::Mode::Wider) {
+                        int width = bIsMoviePlaying ? static_cast<int>(std::round(layout.hudWidth)) : layout.resX;
+                        Elements::SetSize(element, Elements::PackSize(width, size >> 16));
                     }
-                });
-
-            spdlog::info("HUD: Render Textures: 2: Address is {:s}+{:x}", sExeName.c_str(), (uintptr_t)RenderTextures2ScanResult - (uintptr_t)baseModule);
-            static SafetyHookMid RenderTextures2MidHook{};
-            RenderTextures2MidHook = safetyhook::create_mid(RenderTextures2ScanResult,
-                [](SafetyHookContext& ctx) {
-                    if ((int)ctx.r13 == 1920 && ctx.r12 == 1080) {
-                        ctx.r13 = iCurrentResX;
-                        ctx.rdx = iCurrentResX;
-                        ctx.r12 = iCurrentResY;
+                    else {
+                        int height = bIsMoviePlaying ? static_cast<int>(std::round(layout.hudHeight)) : layout.resY;
+                        Elements::SetSize(element, Elements::PackSize(size & 0xFFFF, height));
                     }
-                });
+                }
+            }
+        }), Reg::rax },
+    // Screen size
+    { "HUD: Screen Size", "HUD: Screen Size", &ScreenSizeSig, 0x0, [] { return bFixHUD; },
+        Hooks::ForModes([](auto mode, SafetyHookContext& ctx) {
+            auto layout = Layout::Current();
+            if (ctx.r8 + 0x60) {
+                if (*reinterpret_cast<short*>(ctx.r8 + 0x60) == (short)1920 && *reinterpret_cast<short*>(ctx.r8 + 0x62) == (short)1080) {
+                    if constexpr (mode == Layout::Mode::Wider) {
+                        *reinterpret_cast<short*>(ctx.r8 + 0x60) = static_cast<short>(layout.scaledWidth);
+                    }
+                    else {
+                        *reinterpret_cast<short*>(ctx.r8 + 0x62) = static_cast<short>(layout.scaledHeight);
+                    }
+                }
+            }
+        }), Reg::r8 },
+    // Growth Map
+    { "HUD: Growth Map: Width", "HUD: Growth Map", &GrowthMapSig, 0x0, [] { return bFixHUD; },
+        Hooks::WiderConstant<0>([](const Layout::Snapshot& layout) { return layout.hudWidth; }), Reg::xmm0 },
+    { "HUD: Growth Map: Height", "HUD: Growth Map", &GrowthMapSig, 0x32, [] { return bFixHUD; },
+        Hooks::NarrowerConstant<0>([](const Layout::Snapshot& layout) { return layout.hudHeight; }), Reg::xmm0 },
+    // Soul Map
+    { "HUD: Soul Map: Width", "HUD: Soul Map", &SoulMapSig, 0x0, [] { return bFixHUD; },
+        Hooks::WiderConstant<0>([](const Layout::Snapshot& layout) { return layout.hudWidth; }), Reg::xmm0 },
+    { "HUD: Soul Map: Height", "HUD: Soul Map", &SoulMapSig, 0x32, [] { return bFixHUD; },
+        Hooks::NarrowerConstant<0>([](const Layout::Snapshot& layout) { return layout.hudHeight; }), Reg::xmm0 },
+    // Mission Select
+    { "HUD: Mission Select: 1: Size", "HUD: Mission Select", &MissionSelect1Sig, 0x0, [] { return bFixHUD; },
+        Hooks::WiderConstant<0>([](const Layout::Snapshot& layout) { return layout.hudWidth; }), Reg::xmm0 },
+    { "HUD: Mission Select: 1: Offset", "HUD: Mission Select", &MissionSelect1Sig, -0x1E, [] { return bFixHUD; },
+        Hooks::WiderOnly([](SafetyHookContext& ctx) {
+            auto layout = Layout::Current();
+            ctx.xmm0.f32[0] += layout.widthOffset;
+        }), Reg::xmm0 },
+    { "HUD: Mission Select: 2: Size", "HUD: Mission Select", &MissionSelect2Sig, 0x3, [] { return bFixHUD; },
+        Hooks::ForModes([](auto mode, SafetyHookContext& ctx) {
+            auto layout = Layout::Current();
+            if constexpr (mode == Layout::Mode::Wider)
+                ctx.xmm2.f32[0] = layout.hudWidth;
+            else
+                ctx.xmm3.f32[0] = layout.hudHeight;
+        }), Reg::xmm2 | Reg::xmm3 },
+    { "HUD: Mission Select: 2: Offset Width", "HUD: Mission Select", &MissionSelect2Sig, 0x23, [] { return bFixHUD; },
+        Hooks::WiderOnly([](SafetyHookContext& ctx) {
+            auto layout = Layout::Current();
+            ctx.xmm0.f32[0] += layout.widthOffset;
+        }), Reg::xmm0 },
+    { "HUD: Mission Select: 2: Offset Height", "HUD: Mission Select", &MissionSelect2Sig, 0x14, [] { return bFixHUD; },
+        Hooks::NarrowerOnly([](SafetyHookContext& ctx) {
+            auto layout = Layout::Current();
+            ctx.xmm0.f32[0] += layout.heightOffset;
+        }), Reg::xmm0 },
+
+    // Set 1920x1080 render textures to native resolution
+    { "HUD: Render Textures: 1", "HUD: Render Textures", &RenderTextures1Sig, 0x0, [] { return bRenderTextureRes; },
+        [](SafetyHookContext& ctx) {
+            auto layout = Layout::Current();
+            if ((int)ctx.r10 == 1920 && (int)ctx.r11 == 1080) {
+                ctx.r10 = layout.resX;
+                ctx.r11 = layout.resY;
+            }
+        }, Reg::r10 | Reg::r11 },
+    { "HUD: Render Textures: 2", "HUD: Render Textures", &RenderTextures2Sig, 0x0, [] { return bRenderTextureRes; },
+        [](SafetyHookContext& ctx) {
+            auto layout = Layout::Current();
+            if ((int)ctx.r13 == 1920 && ctx.r12 == 1080) {
+                ctx.r13 = layout.resX;
+                ctx.rdx = layout.resX;
+                ctx.r12 = layout.resY;
+            }
+        }, Reg::rdx | Reg::r12 | Reg::r13 },
+};
+
+// Re-reads the ini and applies only what changed. Addresses found at startup are reused, nothing is rescanned.
+void ReloadConfiguration()
+{
+    std::ifstream iniFile(sThisModulePath.string() + sConfigFile);
+    if (!iniFile) {
+        spdlog::error("Config Reload: Could not open {}", sThisModulePath.string() + sConfigFile);
+        return;
+    }
+
+    // What's live now, to diff against
+    bool bOldFixFOV = bFixFOV, bOldFixAspect = bFixAspect, bOldFixHUD = bFixHUD, bOldSkipIntro = bSkipIntro, bOldRenderTextureRes = bRenderTextureRes;
+    float fOldGameplayFOVMulti = fGameplayFOVMulti;
+    int iOldFramerateCap = iFramerateCap;
+    bool bOldFrameLimiter = bFrameLimiter;
+    int iOldShadowResolution = iShadowResolution;
+
+    spdlog::info("----------");
+    spdlog::info("Config Reload: {} changed, reloading.", sConfigFile);
+    ini.clear();
+    ini.parse(iniFile);
+    ini.strip_trailing_comments();
+    ParseConfig();
+
+    // Settings that can only be applied at startup
+    auto restartRequired = [](const char* section, const char* key, auto current) {
+        auto value = current;
+        inipp::get_value(ini.sections[section], key, value);
+        if (value != current)
+            spdlog::warn("Config Reload: [{}] {} changed, restart the game to apply it.", section, key);
+    };
+    restartRequired("Custom Resolution", "Enabled", bCustomRes);
+    restartRequired("Profiling", "Enabled", bProfiling);
+    restartRequired("Profiling", "Interval", iProfilingInterval);
+    restartRequired("Trace", "Enabled", bTrace);
+    restartRequired("Trace", "Hotkey", iTraceHotkey);
+    restartRequired("Trace", "DumpAfter", iTraceDumpAfter);
+
+    if (iFramerateCap != iOldFramerateCap || bFrameLimiter != bOldFrameLimiter)
+        Framerate();
+
+    if (iShadowResolution != iOldShadowResolution)
+        Misc();
+
+    // Hooks read these through their enabled() predicate
+    if (bFixFOV != bOldFixFOV || bFixAspect != bOldFixAspect || bFixHUD != bOldFixHUD || bSkipIntro != bOldSkipIntro || bRenderTextureRes != bOldRenderTextureRes ||
+        (fGameplayFOVMulti == 1.00f) != (fOldGameplayFOVMulti == 1.00f) || (bFrameLimiter && !bOldFrameLimiter))
+        Hooks::Reconfigure();
+
+    spdlog::info("----------");
+}
+
+// Reloads the config whenever it's saved
+void WatchConfiguration()
+{
+    std::thread([] {
+        auto iniPath = sThisModulePath / sConfigFile;
+        HANDLE change = FindFirstChangeNotificationW(sThisModulePath.wstring().c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+        if (change == INVALID_HANDLE_VALUE) {
+            spdlog::error("Config Reload: Failed to watch {} for changes.", sThisModulePath.string());
+            return;
         }
-        else if (!RenderTextures1ScanResult || !RenderTextures2ScanResult) {
-            spdlog::error("HUD: Render Textures: Pattern scan(s) failed.");
+
+        std::error_code ec;
+        auto lastWrite = std::filesystem::last_write_time(iniPath, ec);
+        while (WaitForSingleObject(change, INFINITE) == WAIT_OBJECT_0) {
+            // Editors often save in several steps, let them finish
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            FindNextChangeNotification(change);
+
+            // Anything else in the folder changing (e.g. the log) also wakes us up
+            auto write = std::filesystem::last_write_time(iniPath, ec);
+            if (ec || write == lastWrite)
+                continue;
+            lastWrite = write;
+            ReloadConfiguration();
         }
-    }    
+        FindCloseChangeNotification(change);
+    }).detach();
 }
 
 DWORD __stdcall Main(void*)
 {
     Logging();
     Configuration();
-    SkipIntro();
+    ScanSignatures();
     Resolution();
-    AspectFOV();
-    HUD();
     Framerate();
     Misc();
+    Hooks::Install(MidHooks, baseModule, sExeName, bProfiling, bTrace, codeIndex.get());
+    if (bProfiling)
+        Profiler::StartSummaryThread(std::chrono::seconds(iProfilingInterval));
+    if (bTrace)
+        Trace::StartDumpThread(sThisModulePath / (sFixName + ".trace"), iTraceHotkey, std::chrono::seconds(iTraceDumpAfter));
+    WatchConfiguration();
     return true;
 }
 
@@ -850,6 +792,10 @@ BOOL APIENTRY DllMain(HMODULE hModule,
     case DLL_PROCESS_ATTACH:
     {
         thisModule = hModule;
+        // Never unloaded. Hooks, the log writer and several detached background threads run our code until the process exits,
+        // so pin the module rather than let a FreeLibrary pull it out from under them.
+        HMODULE pinned;
+        GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_PIN | GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, reinterpret_cast<LPCWSTR>(hModule), &pinned);
         HANDLE mainHandle = CreateThread(NULL, 0, Main, 0, CREATE_SUSPENDED, 0);
         if (mainHandle)
         {
@@ -861,7 +807,12 @@ BOOL APIENTRY DllMain(HMODULE hModule,
     }
     case DLL_THREAD_ATTACH:
     case DLL_THREAD_DETACH:
+        break;
     case DLL_PROCESS_DETACH:
+        // The module is pinned, so this only happens when the process exits and there's nothing to revert.
+        // Write out anything still queued. lpReserved is set when the process is exiting and the log writer thread is already gone.
+        if (logSink)
+            logSink->stop(lpReserved != nullptr);
         break;
     }
     return TRUE;
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace Elements
+{
+    // What a UI element is as far as the Fades hook is concerned
+    enum class Kind : uint8_t { Other, CapturePlane };
+
+    // Element layout
+    constexpr uintptr_t SizeOffset = 0xF0;  // short width, short height
+    constexpr uintptr_t NameOffset = 0x280; // inline char array
+
+    namespace detail
+    {
+        constexpr char CapturePlane[] = "ktglkids_scl_capture_plane_full_rgba8";
+        constexpr size_t CapturePlaneBytes = sizeof(CapturePlane); // Including the terminator
+        static_assert(CapturePlaneBytes > 32 && CapturePlaneBytes <= 40, "Capture plane name no longer fits five overlapping words");
+
+        inline uint64_t Word(const char* bytes, size_t offset)
+        {
+            uint64_t word;
+            memcpy(&word, bytes + offset, sizeof(word));
+            return word;
+        }
+    }
+
+    // Compares the name and its terminator as five overlapping 8-byte words, which is cheaper than strcmp since
+    // most names share the "ktglkids_scl_" prefix. Reads a fixed 38 bytes of the element's name buffer.
+    inline Kind ClassifyName(const char* name)
+    {
+        using detail::Word;
+        constexpr size_t last = detail::CapturePlaneBytes - sizeof(uint64_t);
+        const char* plane = detail::CapturePlane;
+        uint64_t difference = (Word(name, 0) ^ Word(plane, 0)) | (Word(name, 8) ^ Word(plane, 8)) | (Word(name, 16) ^ Word(plane, 16)) |
+            (Word(name, 24) ^ Word(plane, 24)) | (Word(name, last) ^ Word(plane, last));
+        return difference == 0 ? Kind::CapturePlane : Kind::Other;
+    }
+
+    inline Kind Classify(uintptr_t element)
+    {
+        return ClassifyName(reinterpret_cast<const char*>(element + NameOffset));
+    }
+
+    // Width and height packed the way they sit in memory, so a size check or write is a single 32-bit access
+    constexpr uint32_t PackSize(int width, int height)
+    {
+        return (uint32_t)(uint16_t)width | ((uint32_t)(uint16_t)height << 16);
+    }
+
+    inline uint32_t GetSize(uintptr_t element)
+    {
+        uint32_t size;
+        memcpy(&size, reinterpret_cast<const void*>(element + SizeOffset), sizeof(size));
+        return size;
+    }
+
+    // Only writes if the size differs, so elements that are already right don't dirty their cache line every call
+    inline void SetSize(uintptr_t element, uint32_t size)
+    {
+        if (GetSize(element) != size)
+            memcpy(reinterpret_cast<void*>(element + SizeOffset), &size, sizeof(size));
+    }
+
+    constexpr uint32_t FadeSize = PackSize(2689, 1793);
+}
@@ -1,4 +1,6 @@
 #include "stdafx.h"
+#include "mappedfile.hpp"
+#include "patternscan.hpp"
 
 namespace Memory
 {
@@ -19,52 +21,143 @@ namespace Memory
         VirtualProtect((LPVOID)address, numBytes, oldProtect, &oldProtect);
     }
 
-    // CSGOSimple's pattern scan
-    // https://github.com/OneshotGH/CSGOSimple-master/blob/master/CSGOSimple/helpers/utils.cpp
-    std::uint8_t* PatternScan(void* module, const char* signature)
+    std::pair<std::uint8_t*, size_t> GetModuleImage(void* module)
     {
-        static auto pattern_to_byte = [](const char* pattern) {
-            auto bytes = std::vector<int>{};
-            auto start = const_cast<char*>(pattern);
-            auto end = const_cast<char*>(pattern) + strlen(pattern);
-
-            for (auto current = start; current < end; ++current) {
-                if (*current == '?') {
-                    ++current;
-                    if (*current == '?')
-                        ++current;
-                    bytes.push_back(-1);
-                }
-                else {
-                    bytes.push_back(strtoul(current, &current, 16));
-                }
+        auto image = Pe::Image::FromModule(module);
+        return { image.Base(), image.SizeOfImage() };
+    }
+
+    std::vector<std::pair<std::uint8_t*, size_t>> GetSections(void* module, Scanner::Section section)
+    {
+        return GetSections(Pe::Image::FromModule(module), section);
+    }
+
+    void PatternScan(void* module, const std::vector<Signature*>& signatures, unsigned int workers = Scanner::DefaultWorkers())
+    {
+        PatternScan(Pe::Image::FromModule(module), signatures, workers);
+    }
+
+    // Resolves signatures against the module's exe on disk, mapped rather than read so only the pages scanned are loaded.
+    // Doesn't touch the module's memory, so it can run on another thread while the game is still unpacking and initializing.
+    // Returns nothing if the file isn't the same build as the module.
+    std::vector<ImageMatch> ScanFile(void* module, const std::filesystem::path& exePath, const std::vector<Signature*>& signatures, unsigned int workers = Scanner::DefaultWorkers())
+    {
+        MappedFile file(exePath);
+        if (!file)
+            return {};
+
+        auto live = Pe::Image::FromModule(module);
+        Pe::Image image(file.Data(), file.Size(), Pe::Layout::File);
+        if (!image.Valid() || image.Timestamp() != live.Timestamp() || image.SizeOfImage() != live.SizeOfImage())
+            return {};
+        return ScanForRvas(image, signatures, workers);
+    }
+
+    // Takes the addresses found by ScanFile for every signature whose bytes in memory match as well.
+    // Returns the signatures that weren't found on disk or don't match in memory (e.g. a packed exe), they still need a scan.
+    std::vector<Signature*> ApplyFileMatches(void* module, const std::vector<Signature*>& signatures, const std::vector<ImageMatch>& found)
+    {
+        auto [image, imageSize] = GetModuleImage(module);
+        std::vector<Signature*> pending;
+        for (auto signature : signatures) {
+            signature->address = nullptr;
+            auto match = std::find_if(found.begin(), found.end(), [signature](const ImageMatch& match) { return match.signature == signature; });
+            if (match != found.end() && match->rva + signature->pattern.size() <= imageSize && Scanner::Matches(image + match->rva, signature->pattern)) {
+                signature->address = image + match->rva;
+                signature->matches = match->matches;
+                continue;
             }
-            return bytes;
-            };
+            pending.push_back(signature);
+        }
+        return pending;
+    }
 
-        auto dosHeader = (PIMAGE_DOS_HEADER)module;
-        auto ntHeaders = (PIMAGE_NT_HEADERS)((std::uint8_t*)module + dosHeader->e_lfanew);
+    // Waits for a signature that may not be in memory yet on a background thread.
+    // After one full scan only the pages that can have changed since the previous pass are rescanned: writable ones, and any whose
+    // protection changed in between (e.g. unpacked then made read-only again). Read-only code and data isn't read again.
+    // GetWriteWatch can't be used instead, it only tracks memory allocated with MEM_WRITE_WATCH and not the pages of a loaded image.
+    // onFound is called once from the watcher thread with where the signature showed up, or nullptr once the timeout expires.
+    // The signature is only read, publishing its address is up to onFound.
+    // hint is where the signature is expected to appear (e.g. from ScanFile), it's checked on every pass before anything is rescanned.
+    void WatchSignature(void* module, const Signature& signature, std::function<void(std::uint8_t*)> onFound, std::uint8_t* hint = nullptr,
+        std::chrono::milliseconds interval = std::chrono::milliseconds(100), std::chrono::milliseconds timeout = std::chrono::seconds(30))
+    {
+        std::thread([module, pattern = signature.pattern, section = signature.section, onFound = std::move(onFound), hint, interval, timeout] {
+            constexpr size_t pageSize = 0x1000;
+            constexpr DWORD writable = PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+
+            auto ranges = GetSections(module, section);
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+
+            // Protection of every page of every range, a region at a time
+            auto protections = [&ranges] {
+                std::vector<std::vector<DWORD>> pages(ranges.size());
+                for (size_t r = 0; r < ranges.size(); ++r) {
+                    auto [rangeBytes, rangeSize] = ranges[r];
+                    pages[r].resize((rangeSize + pageSize - 1) / pageSize, PAGE_NOACCESS);
+                    MEMORY_BASIC_INFORMATION info;
+                    for (size_t page = 0; page < pages[r].size() && VirtualQuery(rangeBytes + page * pageSize, &info, sizeof(info));) {
+                        auto regionEnd = static_cast<std::uint8_t*>(info.BaseAddress) + info.RegionSize;
+                        for (; page < pages[r].size() && rangeBytes + page * pageSize < regionEnd; ++page)
+                            pages[r][page] = info.State == MEM_COMMIT ? info.Protect : PAGE_NOACCESS;
+                    }
+                }
+                return pages;
+            };
 
-        auto sizeOfImage = ntHeaders->OptionalHeader.SizeOfImage;
-        auto patternBytes = pattern_to_byte(signature);
-        auto scanBytes = reinterpret_cast<std::uint8_t*>(module);
+            auto atHint = [&] { return hint && Scanner::Matches(hint, pattern); };
 
-        auto s = patternBytes.size();
-        auto d = patternBytes.data();
+            // Protections are taken before the initial pass so that anything changed during it is rescanned on the next one
+            auto previous = protections();
+            std::uint8_t* address = atHint() ? hint : nullptr;
+            for (size_t r = 0; r < ranges.size() && !address; ++r) {
+                auto [rangeBytes, rangeSize] = ranges[r];
+                if (auto offset = Scanner::Find(rangeBytes, rangeSize, pattern); offset != Scanner::npos)
+                    address = rangeBytes + offset;
+            }
 
-        for (auto i = 0ul; i < sizeOfImage - s; ++i) {
-            bool found = true;
-            for (auto j = 0ul; j < s; ++j) {
-                if (scanBytes[i + j] != d[j] && d[j] != -1) {
-                    found = false;
+            while (!address && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(interval);
+                if (atHint()) {
+                    address = hint;
                     break;
                 }
+
+                auto current = protections();
+                for (size_t r = 0; r < ranges.size() && !address; ++r) {
+                    auto [rangeBytes, rangeSize] = ranges[r];
+                    const auto& now = current[r];
+                    auto changed = [&](size_t page) {
+                        auto protect = now[page];
+                        if (protect == 0 || (protect & (PAGE_NOACCESS | PAGE_GUARD)))
+                            return false;
+                        return (protect & writable) != 0 || protect != previous[r][page];
+                    };
+
+                    for (size_t page = 0; page < now.size(); ++page) {
+                        // Find the next run of pages that may have changed
+                        size_t runEnd = page;
+                        while (runEnd < now.size() && changed(runEnd))
+                            ++runEnd;
+                        if (runEnd == page)
+                            continue;
+
+                        // Rescan the run plus enough of its neighbours to catch matches that straddle it
+                        size_t begin = page * pageSize;
+                        begin = begin >= pattern.size() - 1 ? begin - (pattern.size() - 1) : 0;
+                        size_t end = (std::min)(rangeSize, runEnd * pageSize + pattern.size() - 1);
+                        if (auto offset = Scanner::Find(rangeBytes + begin, end - begin, pattern); offset != Scanner::npos) {
+                            address = rangeBytes + begin + offset;
+                            break;
+                        }
+                        page = runEnd;
+                    }
+                }
+                previous = std::move(current);
             }
-            if (found) {
-                return &scanBytes[i];
-            }
-        }
-        return nullptr;
+
+            onFound(address);
+        }).detach();
     }
 
     static HMODULE GetThisDllHandle()
@@ -77,9 +170,65 @@ namespace Memory
 
     uint32_t ModuleTimestamp(void* module)
     {
-        auto dosHeader = (PIMAGE_DOS_HEADER)module;
-        auto ntHeaders = (PIMAGE_NT_HEADERS)((std::uint8_t*)module + dosHeader->e_lfanew);
-        return ntHeaders->FileHeader.TimeDateStamp;
+        return Pe::Image::FromModule(module).Timestamp();
+    }
+
+    // Bumped whenever the layout of the cache file changes, older files are ignored
+    constexpr uint32_t SignatureCacheVersion = 2;
+
+    // Reads cached RVAs and match counts for the current build of the module and verifies each RVA with a compare at that offset.
+    // Returns the signatures that were not cached or failed verification and still need a full scan.
+    std::vector<Signature*> LoadSignatureCache(void* module, const std::filesystem::path& cachePath, const std::vector<Signature*>& signatures)
+    {
+        std::ifstream cacheFile(cachePath);
+        uint32_t version = 0;
+        uint32_t timestamp = 0;
+        size_t sizeOfImage = 0;
+        if (!cacheFile || !(cacheFile >> std::hex >> version >> timestamp >> sizeOfImage) || version != SignatureCacheVersion)
+            return signatures;
+
+        auto [image, imageSize] = GetModuleImage(module);
+        if (timestamp != ModuleTimestamp(module) || sizeOfImage != imageSize)
+            return signatures; // Game was updated
+
+        // Key to RVA and how many times it matched
+        std::unordered_map<uint64_t, std::pair<size_t, size_t>> cachedRVAs;
+        uint64_t key;
+        size_t rva, matches;
+        while (cacheFile >> key >> rva >> matches)
+            cachedRVAs[key] = { rva, matches };
+
+        std::vector<Signature*> pending;
+        for (auto signature : signatures) {
+            signature->address = nullptr;
+            auto cached = cachedRVAs.find(SignatureKey(*signature));
+            if (cached != cachedRVAs.end()) {
+                const auto& pattern = signature->pattern;
+                auto [cachedRva, cachedMatches] = cached->second;
+                if (cachedRva + pattern.size() <= imageSize && Scanner::Matches(image + cachedRva, pattern)) {
+                    // Restored as found by the scan so a wrong count is still warned about on every launch
+                    signature->address = image + cachedRva;
+                    signature->matches = cachedMatches;
+                    continue;
+                }
+            }
+            pending.push_back(signature);
+        }
+        return pending;
+    }
+
+    void SaveSignatureCache(void* module, const std::filesystem::path& cachePath, const std::vector<Signature*>& signatures)
+    {
+        std::ofstream cacheFile(cachePath, std::ofstream::out | std::ofstream::trunc);
+        if (!cacheFile)
+            return;
+
+        auto [image, imageSize] = GetModuleImage(module);
+        cacheFile << std::hex << SignatureCacheVersion << " " << ModuleTimestamp(module) << " " << imageSize << "\n";
+        for (auto signature : signatures) {
+            if (signature->address)
+                cacheFile << SignatureKey(*signature) << " " << static_cast<size_t>(signature->address - image) << " " << signature->matches << "\n";
+        }
     }
 
     uintptr_t GetAbsolute(uintptr_t address) noexcept
@@ -0,0 +1,434 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+#include <safetyhook.hpp>
+
+#include "codeindex.hpp"
+#include "inject.hpp"
+#include "layout.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
+
+namespace Hooks
+{
+    enum class Status { Pending, Disabled, ScanFailed, HookFailed, Installed };
+
+    inline const char* StatusName(Status status)
+    {
+        switch (status) {
+        case Status::Disabled: return "Disabled";
+        case Status::ScanFailed: return "Scan Failed";
+        case Status::HookFailed: return "Hook Failed";
+        case Status::Installed: return "Installed";
+        default: return "Pending";
+        }
+    }
+
+    // The callback a hook runs in each aspect ratio mode, nullptr if the hook has nothing to do in that mode.
+    // A plain callback runs in every mode. Use ForModes, WiderOnly or NarrowerOnly for HUD fixes so that
+    // each mode gets its own branch-free function and the hook is switched off entirely at native 16:9.
+    struct Callback
+    {
+        safetyhook::MidHookFn native = nullptr;
+        safetyhook::MidHookFn wider = nullptr;
+        safetyhook::MidHookFn narrower = nullptr;
+        bool perMode = false;
+        // Set by WiderConstant / NarrowerConstant, the register and the value it's set to
+        int xmm = -1;
+        float (*value)(const Layout::Snapshot&) = nullptr;
+
+        template<typename Fn> requires std::is_convertible_v<Fn, safetyhook::MidHookFn>
+        constexpr Callback(Fn callback) : native(callback), wider(callback), narrower(callback) {}
+
+        constexpr Callback(safetyhook::MidHookFn wider, safetyhook::MidHookFn narrower) : wider(wider), narrower(narrower), perMode(true) {}
+
+        safetyhook::MidHookFn For(Layout::Mode mode) const
+        {
+            switch (mode) {
+            case Layout::Mode::Wider: return wider;
+            case Layout::Mode::Narrower: return narrower;
+            default: return native;
+            }
+        }
+    };
+
+    template<Layout::Mode Mode>
+    using ModeTag = std::integral_constant<Layout::Mode, Mode>;
+
+    // Builds a wider and a narrower variant from one generic lambda taking (mode, ctx).
+    // Branch on the mode with if constexpr, it is a compile-time constant in each variant.
+    template<typename Fn>
+    constexpr Callback ForModes(Fn)
+    {
+        static_assert(std::is_empty_v<Fn>, "Mode callbacks can't capture anything");
+        return {
+            [](SafetyHookContext& ctx) { Fn{}(ModeTag<Layout::Mode::Wider>{}, ctx); },
+            [](SafetyHookContext& ctx) { Fn{}(ModeTag<Layout::Mode::Narrower>{}, ctx); },
+        };
+    }
+
+    constexpr Callback WiderOnly(safetyhook::MidHookFn callback) { return { callback, nullptr }; }
+    constexpr Callback NarrowerOnly(safetyhook::MidHookFn callback) { return { nullptr, callback }; }
+
+    namespace detail
+    {
+        template<int Xmm, typename Fn>
+        void SetConstant(SafetyHookContext& ctx)
+        {
+            (&ctx.xmm0)[Xmm].f32[0] = Fn{}(Layout::Current());
+        }
+
+        template<int Xmm, typename Fn>
+        constexpr Callback Constant(Callback callback, Fn)
+        {
+            static_assert(std::is_empty_v<Fn>, "Constant values can't capture anything");
+            static_assert(Xmm >= 0 && Xmm < 16, "No such xmm register");
+            callback.xmm = Xmm;
+            callback.value = Fn{};
+            return callback;
+        }
+    }
+
+    // Sets the low float of xmm<Xmm> to value(layout) in one mode, for hooks that only replace a value that changes with the resolution.
+    // These are injected without a callback where possible (see Inject::Constant) and updated with a single store when the layout changes.
+    // The callback is kept for profiling, tracing, and targets that can't be injected.
+    template<int Xmm, typename Fn>
+    constexpr Callback WiderConstant(Fn value) { return detail::Constant<Xmm>(WiderOnly(&detail::SetConstant<Xmm, Fn>), value); }
+    template<int Xmm, typename Fn>
+    constexpr Callback NarrowerConstant(Fn value) { return detail::Constant<Xmm>(NarrowerOnly(&detail::SetConstant<Xmm, Fn>), value); }
+
+    // One mid hook, placed at signature + offset.
+    // Hooks that share a group are installed together or not at all, so a fix is never half applied.
+    struct MidHook
+    {
+        const char* name;
+        const char* group;
+        Memory::Signature* signature;
+        std::ptrdiff_t offset;
+        bool (*enabled)();
+        Callback callback;
+        // Registers the callback reads or writes, the stub only saves these and the volatile ones (see safetyhook::reg)
+        safetyhook::RegisterMask registers = safetyhook::reg::all;
+
+        SafetyHookMid hook{};
+        std::unique_ptr<Inject::Constant> constant; // Instead of hook, for injected constants
+        Status status = Status::Pending;
+        size_t slot = 0;
+        bool active = false; // Last result of enabled()
+    };
+
+    namespace detail
+    {
+        // Per-mode hooks call through a dispatch slot so their callback can be swapped without touching the stub
+        constexpr size_t MaxSlots = 64;
+        inline std::array<std::atomic<safetyhook::MidHookFn>, MaxSlots> Targets{};
+        inline size_t SlotCount = 0;
+
+        template<size_t Index>
+        void Dispatch(SafetyHookContext& ctx)
+        {
+            Targets[Index].load(std::memory_order_acquire)(ctx);
+        }
+
+        template<size_t... Indices>
+        constexpr std::array<safetyhook::MidHookFn, MaxSlots> MakeDispatchers(std::index_sequence<Indices...>)
+        {
+            return { &Dispatch<Indices>... };
+        }
+
+        inline constexpr auto Dispatchers = MakeDispatchers(std::make_index_sequence<MaxSlots>{});
+
+        // Does nothing, for per-mode slots whose hook has no variant for the current mode until it's patched out
+        inline void Idle(SafetyHookContext&) {}
+
+        inline std::recursive_mutex Mutex;
+        // The mode hooks are patched in or out for, can lag behind the layout until the switcher thread catches up
+        inline Layout::Mode CurrentMode = Layout::Mode::Native;
+        inline std::span<MidHook> Installed;
+        // Bumped by SetLayout to wake the switcher thread
+        inline std::atomic<uint32_t> SwitchRequests = 0;
+
+        // Install() arguments, kept so hooks turned on later by Reconfigure() are created the same way
+        inline void* Module = nullptr;
+        inline std::string ExeName;
+        inline bool Profile = false;
+        inline bool Trace = false;
+        inline const Disasm::CodeIndex* Index = nullptr;
+
+        // Whether the hook should be patched in right now
+        inline bool Wanted(const MidHook& hook)
+        {
+            return hook.active && hook.callback.For(CurrentMode);
+        }
+
+        // Marks every hook in a group that has an unresolved signature as failed, for the hooks that are about to be created
+        inline void FailGroups(std::span<MidHook> hooks)
+        {
+            std::vector<const char*> failedGroups;
+            auto groupFailed = [&failedGroups](const char* group) {
+                return std::find_if(failedGroups.begin(), failedGroups.end(), [group](const char* failed) { return strcmp(failed, group) == 0; }) != failedGroups.end();
+            };
+
+            for (auto& hook : hooks) {
+                if (hook.status == Status::Pending && !hook.signature->address && !groupFailed(hook.group))
+                    failedGroups.push_back(hook.group);
+            }
+
+            for (auto group : failedGroups)
+                spdlog::error("{}: Pattern scan(s) failed.", group);
+
+            for (auto& hook : hooks) {
+                if (hook.status == Status::Pending && groupFailed(hook.group))
+                    hook.status = Status::ScanFailed;
+            }
+        }
+
+        // Creates a pending hook, disabled. The caller decides when to enable it.
+        inline void Create(MidHook& hook)
+        {
+            auto target = hook.signature->address + hook.offset;
+            spdlog::info("{}: Address is {:s}+{:x}", hook.name, ExeName.c_str(), (uintptr_t)target - (uintptr_t)Module);
+
+            // A hook placed mid-instruction would corrupt the code it jumps back into
+            if (Index && !Index->IsBoundary(target)) {
+                hook.status = Status::HookFailed;
+                spdlog::error("{}: Address is not the start of an instruction, not hooking it.", hook.name);
+                return;
+            }
+
+            // Constants fall back to their callback when it needs to be timed, or when they can't be injected
+            if (hook.callback.value && !Profile && !Trace) {
+                hook.constant = Inject::Constant::Create(hook.name, target, hook.signature->address, hook.callback.xmm, hook.callback.value(Layout::Current()),
+                    Pe::Image::FromModule(Module), Index);
+                if (hook.constant) {
+                    hook.status = Status::Installed;
+                    return;
+                }
+                spdlog::warn("{}: Failed to inject, using a mid hook.", hook.name);
+            }
+
+            auto callback = hook.callback.native;
+            if (hook.callback.perMode) {
+                if (SlotCount >= MaxSlots) {
+                    hook.status = Status::HookFailed;
+                    spdlog::error("{}: Out of dispatch slots.", hook.name);
+                    return;
+                }
+
+                // Park the slot on Idle if there's no variant for the mode so it never holds a null callback
+                hook.slot = SlotCount++;
+                auto initial = hook.callback.For(CurrentMode);
+                Targets[hook.slot].store(initial ? initial : &Idle, std::memory_order_release);
+                callback = Dispatchers[hook.slot];
+            }
+
+            if (Profile)
+                callback = Profiler::Wrap(hook.name, callback);
+            if (Trace)
+                callback = Trace::Wrap(hook.name, callback);
+
+            auto result = safetyhook::MidHook::create(target, callback, safetyhook::MidHook::StartDisabled, hook.registers);
+            if (!result) {
+                hook.status = Status::HookFailed;
+                spdlog::error("{}: Failed to create hook ({}).", hook.name, result.error().type == safetyhook::MidHook::Error::BAD_ALLOCATION ? "bad allocation" : "bad inline hook");
+                return;
+            }
+
+            hook.hook = std::move(*result);
+            hook.status = Status::Installed;
+        }
+
+        inline bool Enabled(const MidHook& hook)
+        {
+            return hook.constant ? hook.constant->Enabled() : hook.hook.enabled();
+        }
+
+        // Queues an installed hook to be patched in or out. Rewritten constants switch straight away with a single store.
+        inline void Enable(safetyhook::HookBatch& batch, MidHook& hook, bool bEnable)
+        {
+            if (hook.constant)
+                hook.constant->Enable(batch, bEnable);
+            else if (bEnable)
+                batch.add(hook.hook);
+            else
+                batch.remove(hook.hook);
+        }
+
+        // Updates injected constants and points per-mode slots at the variant for the layout's mode.
+        // Constants with no value in the mode go back to the game's own until they're patched out.
+        // Only single stores, so it's safe from a hook callback. Needs Mutex.
+        inline void Retarget(const Layout::Snapshot& layout)
+        {
+            for (auto& hook : Installed) {
+                if (hook.constant && hook.callback.For(layout.mode))
+                    hook.constant->Set(hook.callback.value(layout));
+                else if (hook.constant)
+                    hook.constant->Clear();
+                else if (hook.status == Status::Installed && hook.callback.perMode)
+                    Targets[hook.slot].store(hook.callback.For(layout.mode) ? hook.callback.For(layout.mode) : &Idle, std::memory_order_release);
+            }
+        }
+
+        // Patches hooks in or out for a new mode with one freeze for all. Suspends every other thread, so never call it from a hook. Needs Mutex.
+        inline void SwitchMode(Layout::Mode mode)
+        {
+            CurrentMode = mode;
+            safetyhook::HookBatch batch;
+            for (auto& hook : Installed) {
+                if (hook.status == Status::Installed && hook.callback.perMode && Wanted(hook) != Enabled(hook))
+                    Enable(batch, hook, Wanted(hook));
+            }
+
+            if (auto result = batch.commit())
+                spdlog::info("Hooks: Switched to {} mode, enabled {} and disabled {} hook(s) ({:.3f}ms frozen).", Layout::ModeName(mode), result->enabled, result->disabled, result->frozen_for.count() / 1000000.0);
+            else
+                spdlog::error("Hooks: Failed to switch to {} mode.", Layout::ModeName(mode));
+        }
+
+        // Applies the latest layout whenever SetLayout asks, so the thread freeze for a mode switch never happens on the render thread
+        inline void StartSwitcher()
+        {
+            std::thread([] {
+                uint32_t seen = 0;
+                while (true) {
+                    SwitchRequests.wait(seen, std::memory_order_acquire);
+                    seen = SwitchRequests.load(std::memory_order_acquire);
+
+                    std::scoped_lock lock(Mutex);
+                    auto layout = Layout::Current();
+                    Retarget(layout);
+                    if (layout.mode != CurrentMode)
+                        SwitchMode(layout.mode);
+                }
+            }).detach();
+        }
+    }
+
+    // Installs every enabled hook in the table. Signatures must already be resolved (see Memory::PatternScan).
+    // Hooks are created disabled and then enabled together, so the game's threads are only suspended once.
+    // Per-mode hooks start with the variant for the current layout, or stay disabled if it has none.
+    // With profiling on, each callback is wrapped in a timer (see Profiler::Wrap).
+    // With tracing on, each callback's calls and time are also recorded per frame (see Trace::Wrap).
+    // Given a code index, hooks whose address isn't the start of an instruction are refused. The index has to outlive the hooks.
+    inline void Install(std::span<MidHook> hooks, void* module, const std::string& exeName, bool bProfile = false, bool bTrace = false, const Disasm::CodeIndex* index = nullptr)
+    {
+        std::scoped_lock lock(detail::Mutex);
+        detail::CurrentMode = Layout::Current().mode;
+        detail::Installed = hooks;
+        detail::Module = module;
+        detail::ExeName = exeName;
+        detail::Profile = bProfile;
+        detail::Trace = bTrace;
+        detail::Index = index;
+
+        for (auto& hook : hooks) {
+            hook.active = hook.enabled();
+            if (!hook.active)
+                hook.status = Status::Disabled;
+        }
+        detail::FailGroups(hooks);
+
+        safetyhook::HookBatch batch;
+        for (auto& hook : hooks) {
+            if (hook.status != Status::Pending)
+                continue;
+
+            detail::Create(hook);
+            if (hook.status == Status::Installed && detail::Wanted(hook))
+                detail::Enable(batch, hook, true);
+        }
+
+        // Allocate the trace ring before any hook can run
+        if (bTrace)
+            Trace::Start();
+        detail::StartSwitcher();
+
+        if (auto result = batch.commit()) {
+            spdlog::info("Hooks: Enabled {} hooks with a single thread freeze ({:.3f}ms frozen).", result->enabled, result->frozen_for.count() / 1000000.0);
+        }
+        else {
+            // Nothing from the batch was left patched, fall back to enabling them one at a time
+            spdlog::error("Hooks: Batch enable failed at {:s}+{:x}, enabling hooks individually.", exeName.c_str(), (uintptr_t)result.error().ip - (uintptr_t)module);
+            for (auto& hook : hooks) {
+                if (hook.status == Status::Installed && detail::Wanted(hook) && !detail::Enabled(hook) &&
+                    !(hook.constant ? hook.constant->EnableNow() : hook.hook.enable().has_value())) {
+                    hook.status = Status::HookFailed;
+                    spdlog::error("{}: Failed to enable hook.", hook.name);
+                }
+            }
+        }
+
+        auto count = [&hooks](Status status) { return std::count_if(hooks.begin(), hooks.end(), [status](const MidHook& hook) { return hook.status == status; }); };
+        auto idle = std::count_if(hooks.begin(), hooks.end(), [](const MidHook& hook) { return hook.status == Status::Installed && !detail::Enabled(hook); });
+        spdlog::info("----------");
+        spdlog::info("Hooks: Installed {}/{} hooks ({} disabled, {} scan failed, {} hook failed).", count(Status::Installed), hooks.size(),
+            count(Status::Disabled), count(Status::ScanFailed), count(Status::HookFailed));
+        spdlog::info("Hooks: {} mode, {} installed hook(s) idle until the aspect ratio changes.", Layout::ModeName(detail::CurrentMode), idle);
+        for (const auto& hook : hooks) {
+            if (hook.status != Status::Installed && hook.status != Status::Disabled)
+                spdlog::info("Hooks: {}: {}", hook.name, StatusName(hook.status));
+        }
+        spdlog::info("----------");
+    }
+
+    // Re-evaluates every hook's enabled() after a config change and turns hooks on or off to match.
+    // Hooks that were off at startup are created on first use from the addresses found at startup, nothing is rescanned.
+    inline void Reconfigure()
+    {
+        std::scoped_lock lock(detail::Mutex);
+        if (detail::Installed.empty())
+            return;
+
+        for (auto& hook : detail::Installed) {
+            hook.active = hook.enabled();
+            if (hook.active && hook.status == Status::Disabled)
+                hook.status = Status::Pending;
+        }
+        detail::FailGroups(detail::Installed);
+
+        safetyhook::HookBatch batch;
+        for (auto& hook : detail::Installed) {
+            if (hook.status == Status::Pending)
+                detail::Create(hook);
+            if (hook.status != Status::Installed)
+                continue;
+
+            if (detail::Wanted(hook) != detail::Enabled(hook))
+                detail::Enable(batch, hook, detail::Wanted(hook));
+        }
+
+        if (auto result = batch.commit())
+            spdlog::info("Hooks: Reconfigured, enabled {} and disabled {} hook(s) ({:.3f}ms frozen).", result->enabled, result->disabled, result->frozen_for.count() / 1000000.0);
+        else
+            spdlog::error("Hooks: Failed to apply hook changes at {:s}+{:x}.", detail::ExeName.c_str(), (uintptr_t)result.error().ip - (uintptr_t)detail::Module);
+    }
+
+    // Updates injected constants for a new layout and points every installed per-mode hook at its variant for the mode, as single stores.
+    // Called from the CurrentResolution hook on the render thread, so it never waits on a lock or freezes threads. Hooks that need patching
+    // in or out for a new mode are left to the switcher thread, as is everything if another thread holds the lock. Does nothing before Install.
+    // The layout must already be published (see Layout::Publish), the switcher thread reads it back from there.
+    inline void SetLayout(const Layout::Snapshot& layout)
+    {
+        std::unique_lock lock(detail::Mutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            if (detail::Installed.empty())
+                return;
+            detail::Retarget(layout);
+            if (layout.mode == detail::CurrentMode)
+                return;
+        }
+
+        detail::SwitchRequests.fetch_add(1, std::memory_order_release);
+        detail::SwitchRequests.notify_one();
+    }
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <safetyhook.hpp>
+#include <Zydis.h>
+
+#include "codeindex.hpp"
+#include "pe.hpp"
+
+// Hooks that only set the low float of an xmm register to a value the fix works out ahead of time.
+// Nothing calls back into the fix, the game reads the value from a float we own and updating it is a single store.
+namespace Inject
+{
+    enum class Kind { Rewrite, Stub };
+
+    class Constant
+    {
+    public:
+        // Prefers pointing a "movss xmm, [rip+x]" that loads the register right before target at our float, which costs nothing per call.
+        // Otherwise hooks target with a stub that inserts our float into the register and carries on through the trampoline.
+        // Only instructions from earliest on are considered, so the load has to be part of the signature match. Rewriting also needs
+        // the code index of image, to be sure the load is a real instruction and nothing in the function jumps past it to target.
+        // Starts disabled, returns nullptr if neither works so the caller can fall back to a mid hook.
+        static std::unique_ptr<Constant> Create(const char* name, std::uint8_t* target, const std::uint8_t* earliest, int xmm, float value,
+            const Pe::Image& image, const Disasm::CodeIndex* index)
+        {
+            std::unique_ptr<Constant> constant(new Constant());
+            constant->_value = value;
+            if (index && constant->Rewrite(target, earliest, xmm, image, *index)) {
+                spdlog::info("{}: Injecting xmm{} by rewriting the load {} byte(s) before the hook.", name, xmm, target - constant->_load);
+                return constant;
+            }
+            if (constant->Hook(target, xmm)) {
+                spdlog::info("{}: Injecting xmm{} with a stub.", name, xmm);
+                return constant;
+            }
+            return nullptr;
+        }
+
+        ~Constant()
+        {
+            // Point the load back at the game's own constant before our float goes away
+            if (_bRewritten) {
+                safetyhook::HookBatch batch;
+                batch.write(_displacement, Bytes(_originalDisplacement));
+                (void)batch.commit();
+            }
+        }
+
+        Constant(const Constant&) = delete;
+        Constant& operator=(const Constant&) = delete;
+
+        Kind GetKind() const { return _hook ? Kind::Stub : Kind::Rewrite; }
+
+        bool Enabled() const { return _hook ? _hook.enabled() : _bEnabled; }
+
+        // A stub is queued on the batch to be patched in or out with everything else. A rewritten load is switched with a single store,
+        // the first time it's enabled the new displacement is queued on the batch too so it's written while the game's threads are frozen.
+        void Enable(safetyhook::HookBatch& batch, bool bEnable)
+        {
+            if (_hook) {
+                bEnable ? batch.add(_hook) : batch.remove(_hook);
+                return;
+            }
+            _bEnabled = bEnable;
+            _slot->store(bEnable ? _value : _original, std::memory_order_relaxed);
+            if (bEnable && !_bRewritten) {
+                batch.write(_displacement, Bytes(_newDisplacement));
+                _bRewritten = true; // Writes are applied even if the batch fails
+            }
+        }
+
+        // Patches a stub or the displacement in on its own, for when a batch fails
+        bool EnableNow()
+        {
+            if (!_hook) {
+                safetyhook::HookBatch batch;
+                Enable(batch, true);
+                return batch.commit().has_value();
+            }
+            return _hook.enable().has_value();
+        }
+
+        void Set(float value)
+        {
+            _value = value;
+            if (_hook) {
+                _slot->store(value, std::memory_order_relaxed);
+                _entry->store(_insert, std::memory_order_release);
+            }
+            else if (_bEnabled) {
+                _slot->store(value, std::memory_order_relaxed);
+            }
+        }
+
+        // Leaves the register as the game sets it until the next Set, for a mode the constant has no value in.
+        // Takes effect straight away while still patched in: a rewritten load reads the game's value again, a stub jumps past the insert.
+        void Clear()
+        {
+            if (_hook)
+                _entry->store(_trampoline, std::memory_order_release);
+            else if (_bEnabled)
+                _slot->store(_original, std::memory_order_relaxed);
+        }
+
+    private:
+        Constant() = default;
+
+        // Declared first so the hook is undone before it's freed
+        safetyhook::Allocation _memory;
+        SafetyHookInline _hook{};
+        std::atomic<float>* _slot = nullptr;
+        // Where a stub jumps on entry, its insert or straight to the trampoline while cleared
+        std::atomic<std::uint8_t*>* _entry = nullptr;
+        std::uint8_t* _insert = nullptr;
+        std::uint8_t* _trampoline = nullptr;
+        float _value = 0.0f;
+        float _original = 0.0f;
+        bool _bEnabled = false;
+        const std::uint8_t* _load = nullptr;
+        // The load's displacement, and what it is before and after the rewrite
+        std::uint8_t* _displacement = nullptr;
+        std::int32_t _originalDisplacement = 0;
+        std::int32_t _newDisplacement = 0;
+        bool _bRewritten = false;
+
+        static_assert(sizeof(std::atomic<float>) == sizeof(float) && std::atomic<float>::is_always_lock_free, "The game reads the slot as a plain float");
+        static_assert(sizeof(std::atomic<std::uint8_t*>) == sizeof(void*) && std::atomic<std::uint8_t*>::is_always_lock_free, "The stub jumps through the entry as a plain pointer");
+
+        void PlaceSlot(std::uint8_t* slot, float value)
+        {
+            _slot = new (slot) std::atomic<float>(value);
+        }
+
+        static std::vector<std::uint8_t> Bytes(std::int32_t value)
+        {
+            auto bytes = reinterpret_cast<const std::uint8_t*>(&value);
+            return { bytes, bytes + sizeof(value) };
+        }
+
+        // A load of the register from a RIP-relative constant ending exactly at target leaves it holding that constant at target.
+        // Pointing the load at our float instead is the same as a hook setting the register there, as long as nothing jumps straight to target.
+        // The constant has to be read-only, our float only takes a copy of it.
+        bool Rewrite(std::uint8_t* target, const std::uint8_t* earliest, int xmm, const Pe::Image& image, const Disasm::CodeIndex& index)
+        {
+            if (index.IsBranchTarget(target))
+                return false;
+
+            ZydisDecoder decoder;
+            if (!ZYAN_SUCCESS(ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64)))
+                return false;
+
+            // "movss xmm, [rip+x]" is at least 8 bytes
+            for (size_t length = 8; length <= ZYDIS_MAX_INSTRUCTION_LENGTH && target - length >= earliest; ++length) {
+                auto load = target - length;
+                ZydisDecodedInstruction ix;
+                ZydisDecodedOperand operands[ZYDIS_MAX_OPERAND_COUNT];
+                if (!index.IsBoundary(load) || !ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, load, length, &ix, operands)) || ix.length != length)
+                    continue;
+                if ((ix.mnemonic != ZYDIS_MNEMONIC_MOVSS && ix.mnemonic != ZYDIS_MNEMONIC_VMOVSS) || ix.operand_count_visible != 2)
+                    continue;
+                if (operands[0].type != ZYDIS_OPERAND_TYPE_REGISTER || operands[0].reg.value != ZYDIS_REGISTER_XMM0 + xmm)
+                    continue;
+                if (operands[1].type != ZYDIS_OPERAND_TYPE_MEMORY || operands[1].mem.base != ZYDIS_REGISTER_RIP || ix.raw.disp.size != 32)
+                    continue;
+
+                ZyanU64 source;
+                if (!ZYAN_SUCCESS(ZydisCalcAbsoluteAddress(&ix, &operands[1], (ZyanU64)load, &source)))
+                    return false;
+                auto rva = image.RvaOf(reinterpret_cast<const std::uint8_t*>(source));
+                const auto* section = rva != Pe::npos ? image.SectionAt(rva) : nullptr;
+                if (!section || section->Writable())
+                    return false;
+
+                // The new displacement has to reach our float
+                auto allocation = safetyhook::Allocator::global()->allocate_near({ load }, 2 * sizeof(float), 0x7FFF0000);
+                if (!allocation)
+                    return false;
+                _memory = std::move(*allocation);
+                auto slot = reinterpret_cast<std::uint8_t*>((_memory.address() + alignof(float) - 1) & ~(uintptr_t)(alignof(float) - 1));
+
+                // Starts holding the game's value so the rewrite alone changes nothing until Enable()
+                _original = *reinterpret_cast<const float*>(source);
+                PlaceSlot(slot, _original);
+                auto displacement = (std::int64_t)(slot - (load + ix.length));
+                if (displacement < INT32_MIN || displacement > INT32_MAX)
+                    return false;
+
+                // Written by Enable() under the batch's thread freeze, a displacement is four bytes that may straddle a cache line
+                _displacement = load + ix.raw.disp.offset;
+                _originalDisplacement = (std::int32_t)ix.raw.disp.value;
+                _newDisplacement = (std::int32_t)displacement;
+                _load = load;
+                return true;
+            }
+            return false;
+        }
+
+        // Stub: jmp [rip+entry] / insert: insertps xmm, [rip+slot], 0 / jmp [rip+trampoline]
+        // insertps only replaces the low float, the same as writing ctx.xmmN.f32[0] from a mid hook.
+        bool Hook(std::uint8_t* target, int xmm)
+        {
+            constexpr size_t CodeOffset = 24;
+            constexpr size_t Size = 64;
+            auto allocation = safetyhook::Allocator::global()->allocate(Size + 8);
+            if (!allocation)
+                return false;
+            _memory = std::move(*allocation);
+
+            // Float at 0, trampoline address at 8, entry at 16, code after
+            auto base = reinterpret_cast<std::uint8_t*>((_memory.address() + 7) & ~(uintptr_t)7);
+            auto trampolineSlot = base + 8;
+            auto entrySlot = base + 16;
+            auto code = base + CodeOffset;
+            PlaceSlot(base, _value);
+
+            auto encode = [](ZydisEncoderRequest& request, std::uint8_t* at, std::uint8_t* end) -> std::uint8_t* {
+                request.machine_mode = ZYDIS_MACHINE_MODE_LONG_64;
+                ZyanUSize length = end - at;
+                if (!ZYAN_SUCCESS(ZydisEncoderEncodeInstructionAbsolute(&request, at, &length, (ZyanU64)at)))
+                    return nullptr;
+                return at + length;
+            };
+
+            ZydisEncoderRequest dispatch{};
+            dispatch.mnemonic = ZYDIS_MNEMONIC_JMP;
+            dispatch.operand_count = 1;
+            dispatch.operands[0].type = ZYDIS_OPERAND_TYPE_MEMORY;
+            dispatch.operands[0].mem.base = ZYDIS_REGISTER_RIP;
+            dispatch.operands[0].mem.displacement = (ZyanI64)entrySlot;
+            dispatch.operands[0].mem.size = sizeof(void*);
+
+            ZydisEncoderRequest insert{};
+            insert.mnemonic = ZYDIS_MNEMONIC_INSERTPS;
+            insert.operand_count = 3;
+            insert.operands[0].type = ZYDIS_OPERAND_TYPE_REGISTER;
+            insert.operands[0].reg.value = (ZydisRegister)(ZYDIS_REGISTER_XMM0 + xmm);
+            insert.operands[1].type = ZYDIS_OPERAND_TYPE_MEMORY;
+            insert.operands[1].mem.base = ZYDIS_REGISTER_RIP;
+            insert.operands[1].mem.displacement = (ZyanI64)base;
+            insert.operands[1].mem.size = sizeof(float);
+            insert.operands[2].type = ZYDIS_OPERAND_TYPE_IMMEDIATE;
+            insert.operands[2].imm.u = 0;
+
+            ZydisEncoderRequest jump{};
+            jump.mnemonic = ZYDIS_MNEMONIC_JMP;
+            jump.operand_count = 1;
+            jump.operands[0].type = ZYDIS_OPERAND_TYPE_MEMORY;
+            jump.operands[0].mem.base = ZYDIS_REGISTER_RIP;
+            jump.operands[0].mem.displacement = (ZyanI64)trampolineSlot;
+            jump.operands[0].mem.size = sizeof(void*);
+
+            auto end = base + Size;
+            _insert = encode(dispatch, code, end);
+            auto next = _insert ? encode(insert, _insert, end) : nullptr;
+            if (!next || !encode(jump, next, end))
+                return false;
+            _entry = new (entrySlot) std::atomic<std::uint8_t*>(_insert);
+
+            auto hook = safetyhook::InlineHook::create(safetyhook::Allocator::global(), target, code, safetyhook::InlineHook::StartDisabled);
+            if (!hook)
+                return false;
+            _hook = std::move(*hook);
+            _trampoline = _hook.trampoline().data();
+            *reinterpret_cast<std::uint8_t**>(trampolineSlot) = _trampoline;
+            return true;
+        }
+    };
+}
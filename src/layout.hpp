@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+namespace Layout
+{
+    // Sequence lock around a small trivially copyable value.
+    // Readers never block or write shared memory. They retry if a write happened while they were copying.
+    // The value is stored as relaxed atomic words so a torn read is never a data race, just a retry.
+    // The sequence and the value share one cache line when the value is 56 bytes or less, so a read touches only that line.
+    template<typename T>
+    class SeqLock
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "SeqLock value must be trivially copyable");
+        static_assert(sizeof(T) % sizeof(uint64_t) == 0, "SeqLock value must be a multiple of 8 bytes");
+
+    public:
+        T Load() const
+        {
+            std::array<uint64_t, Words> words;
+            uint64_t before, after;
+            do {
+                before = _sequence.load(std::memory_order_acquire);
+                for (size_t i = 0; i < Words; ++i)
+                    words[i] = _words[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = _sequence.load(std::memory_order_relaxed);
+            } while ((before & 1) || before != after);
+
+            T value;
+            memcpy(&value, words.data(), sizeof(T));
+            return value;
+        }
+
+        void Store(const T& value)
+        {
+            std::array<uint64_t, Words> words;
+            memcpy(words.data(), &value, sizeof(T));
+
+            // Writers are rare, serialize them so the sequence stays consistent
+            std::scoped_lock lock(_writeMutex);
+            auto sequence = _sequence.load(std::memory_order_relaxed);
+            _sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < Words; ++i)
+                _words[i].store(words[i], std::memory_order_relaxed);
+            _sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+    private:
+        static constexpr size_t Words = sizeof(T) / sizeof(uint64_t);
+
+        alignas(64) std::atomic<uint64_t> _sequence{ 0 };
+        std::array<std::atomic<uint64_t>, Words> _words{};
+        // Only writers touch this, keep it off the readers' line
+        alignas(64) std::mutex _writeMutex;
+    };
+
+    // Which way the screen differs from the native 16:9. HUD hooks only do anything outside of Native.
+    enum class Mode : uint8_t { Native, Wider, Narrower };
+
+    inline const char* ModeName(Mode mode)
+    {
+        switch (mode) {
+        case Mode::Wider: return "Wider";
+        case Mode::Narrower: return "Narrower";
+        default: return "Native";
+        }
+    }
+
+    // Everything the hooks need to know about the current resolution, worked out once per resolution change.
+    // Kept to 56 bytes so it fits in one cache line with its SeqLock sequence.
+    struct Snapshot
+    {
+        int resX;
+        int resY;
+        float aspectRatio;
+
+        // HUD area, native aspect ratio centred in the screen
+        float hudWidth;
+        float hudHeight;
+
+        // 1920x1080 HUD space stretched to the current aspect ratio
+        float scaledWidth;     // 1080 * aspect ratio
+        float scaledHeight;    // 1920 / aspect ratio
+        float widthScale;      // 1920 / scaledWidth
+        float heightScale;     // 1080 / scaledHeight
+        float widthOffset;     // (scaledWidth - 1920) / 2
+        float heightOffset;    // (scaledHeight - 1080) / 2
+
+        // 2689x1793 fade to black
+        float fadeWidth;
+        float fadeHeight;
+
+        Mode mode;
+    };
+    static_assert(sizeof(Snapshot) + sizeof(uint64_t) <= 64, "Layout snapshot should fit in one cache line with its sequence");
+
+    inline Snapshot Compute(int resX, int resY, float nativeAspect)
+    {
+        Snapshot layout{};
+        layout.resX = resX;
+        layout.resY = resY;
+        layout.aspectRatio = (float)resX / (float)resY;
+        layout.mode = layout.aspectRatio > nativeAspect ? Mode::Wider : layout.aspectRatio < nativeAspect ? Mode::Narrower : Mode::Native;
+
+        layout.hudWidth = resY * nativeAspect;
+        layout.hudHeight = (float)resY;
+        if (layout.mode == Mode::Narrower) {
+            layout.hudWidth = (float)resX;
+            layout.hudHeight = (float)resX / nativeAspect;
+        }
+
+        layout.scaledWidth = 1080.00f * layout.aspectRatio;
+        layout.scaledHeight = 1920.00f / layout.aspectRatio;
+        layout.widthScale = 1920.00f / layout.scaledWidth;
+        layout.heightScale = 1080.00f / layout.scaledHeight;
+        layout.widthOffset = (layout.scaledWidth - 1920.00f) / 2.00f;
+        layout.heightOffset = (layout.scaledHeight - 1080.00f) / 2.00f;
+
+        layout.fadeWidth = 1793 * layout.aspectRatio;
+        layout.fadeHeight = 2689 / layout.aspectRatio;
+        return layout;
+    }
+
+    inline SeqLock<Snapshot> Published;
+
+    // Called from hook callbacks, returns a consistent copy of the latest layout
+    inline Snapshot Current() { return Published.Load(); }
+
+    inline void Publish(const Snapshot& layout) { Published.Store(layout); }
+}
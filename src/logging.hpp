@@ -0,0 +1,247 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <windows.h>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/pattern_formatter.h>
+#include <spdlog/sinks/sink.h>
+
+// Log file sink that never touches the disk on the calling thread, so it's safe to log from inside hooks.
+// The caller formats the message into a slot of a lock-free ring, a background thread writes the ring out in batches.
+// The file is truncated on open and stops growing once max_size bytes have been written.
+// If the ring is full the message is dropped rather than stalling the caller, the writer logs how many were lost.
+class async_file_sink final : public spdlog::sinks::sink {
+public:
+    static constexpr size_t slot_count = 1024;
+    static constexpr size_t slot_size = 512 - sizeof(size_t) - sizeof(uint32_t); // Longer messages are truncated
+
+    async_file_sink(const std::string& filename, size_t max_size)
+        : _state(std::make_shared<state>(max_size)), _formatter(std::make_unique<spdlog::pattern_formatter>()) {
+        _state->file.open(filename, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!_state->file.is_open()) {
+            throw spdlog::spdlog_ex("Failed to open log file " + filename);
+        }
+
+        // The writer shares ownership of the ring so it can outlive the sink if it's still finishing a batch
+        std::thread([state = _state] { state->run(); }).detach();
+    }
+
+    ~async_file_sink() override {
+        stop();
+    }
+
+    void log(const spdlog::details::log_msg& msg) override {
+        // Formatters aren't thread safe, so each thread formats with its own copy. Cloning it and sizing the buffer to a slot
+        // allocates, once per thread and again after set_formatter. After that only messages longer than a slot allocate.
+        thread_local struct {
+            const async_file_sink* owner = nullptr;
+            uint32_t generation = 0;
+            std::unique_ptr<spdlog::formatter> formatter;
+            spdlog::memory_buf_t formatted;
+        } local;
+
+        auto generation = _formatter_generation.load(std::memory_order_acquire);
+        if (local.owner != this || local.generation != generation || !local.formatter) {
+            std::scoped_lock lock(_formatter_mutex);
+            local.owner = this;
+            local.generation = _formatter_generation.load(std::memory_order_relaxed);
+            local.formatter = _formatter->clone();
+            local.formatted.reserve(slot_size);
+        }
+
+        local.formatted.clear();
+        local.formatter->format(msg, local.formatted);
+        _state->push(local.formatted.data(), local.formatted.size());
+    }
+
+    // Blocks until everything logged before the call has been written to the file
+    void flush() override {
+        auto target = _state->head.load(std::memory_order_acquire);
+        while (_state->tail.load(std::memory_order_acquire) < target && !_state->stopped.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void set_pattern(const std::string& pattern) override {
+        set_formatter(std::make_unique<spdlog::pattern_formatter>(pattern));
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override {
+        std::scoped_lock lock(_formatter_mutex);
+        _formatter = std::move(formatter);
+        _formatter_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    // Writes out whatever is left in the ring and stops the writer. Safe to call from DllMain or a crash handler.
+    // Set process_exiting when other threads may have been terminated, possibly in the middle of writing a batch.
+    void stop(bool process_exiting = false) {
+        _state->stop(process_exiting);
+    }
+
+    // Makes an unhandled exception write out the ring before the process dies
+    void flush_on_crash() {
+        crash_state() = _state;
+        previous_filter() = SetUnhandledExceptionFilter(&unhandled_exception_filter);
+    }
+
+private:
+    struct slot {
+        std::atomic<size_t> sequence;
+        uint32_t length;
+        char data[slot_size];
+    };
+
+    // Bounded multi-producer ring (Vyukov), drained by whichever thread holds the consumer flag
+    struct state {
+        explicit state(size_t max_size) : max_size(max_size), slots(std::make_unique<slot[]>(slot_count)) {
+            for (size_t i = 0; i < slot_count; ++i) {
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            batch.reserve(64 * 1024);
+        }
+
+        void push(const char* data, size_t length) {
+            size_t pos = head.load(std::memory_order_relaxed);
+            slot* target;
+            while (true) {
+                target = &slots[pos & (slot_count - 1)];
+                auto sequence = target->sequence.load(std::memory_order_acquire);
+                auto diff = (intptr_t)sequence - (intptr_t)pos;
+                if (diff == 0) {
+                    if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                else if (diff < 0) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                else {
+                    pos = head.load(std::memory_order_relaxed);
+                }
+            }
+
+            if (length > slot_size) {
+                // Keep the line ending so truncated messages don't run into the next one
+                memcpy(target->data, data, slot_size - 1);
+                target->data[slot_size - 1] = '\n';
+                length = slot_size;
+            }
+            else {
+                memcpy(target->data, data, length);
+            }
+            target->length = (uint32_t)length;
+            target->sequence.store(pos + 1, std::memory_order_release);
+        }
+
+        void run() {
+            while (!stopping.load(std::memory_order_acquire)) {
+                drain(false);
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            // stop() may have found this thread mid-batch and left the rest to it
+            drain(false);
+        }
+
+        void stop(bool process_exiting) {
+            stopping.store(true, std::memory_order_release);
+            drain(process_exiting);
+            stopped.store(true, std::memory_order_release);
+        }
+
+        // Writes every committed message to the file in one go.
+        // Without force it leaves the ring to another thread that's already draining it and doesn't finish within 100ms.
+        // force takes over regardless, only for when the process is exiting and that thread may have been terminated mid-batch.
+        void drain(bool force) {
+            if (consuming.test_and_set(std::memory_order_acquire) && !force) {
+                // Another thread is draining, give it a moment to finish
+                int tries = 0;
+                while (consuming.test_and_set(std::memory_order_acquire)) {
+                    if (++tries == 100) {
+                        return;
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+
+            auto pos = tail.load(std::memory_order_relaxed);
+            while (true) {
+                auto& current = slots[pos & (slot_count - 1)];
+                if (current.sequence.load(std::memory_order_acquire) != pos + 1) {
+                    break;
+                }
+                append(current.data, current.length);
+                current.sequence.store(pos + slot_count, std::memory_order_release);
+                tail.store(++pos, std::memory_order_release);
+            }
+
+            if (auto lost = dropped.exchange(0, std::memory_order_relaxed)) {
+                char message[96];
+                auto length = snprintf(message, sizeof(message), "[async_file_sink] %zu message(s) dropped, log buffer was full.\n", lost);
+                append(message, (size_t)length);
+            }
+
+            if (!batch.empty()) {
+                file.write(batch.data(), batch.size());
+                file.flush();
+                batch.clear();
+            }
+
+            consuming.clear(std::memory_order_release);
+        }
+
+        void append(const char* data, size_t length) {
+            if (written >= max_size) {
+                return;
+            }
+            batch.insert(batch.end(), data, data + length);
+            written += length;
+        }
+
+        std::ofstream file;
+        size_t max_size;
+        size_t written = 0;
+        std::vector<char> batch;
+
+        std::unique_ptr<slot[]> slots;
+        alignas(64) std::atomic<size_t> head{ 0 };
+        alignas(64) std::atomic<size_t> tail{ 0 };
+        std::atomic<size_t> dropped{ 0 };
+        std::atomic_flag consuming;
+        std::atomic<bool> stopping{ false };
+        std::atomic<bool> stopped{ false };
+    };
+
+    static std::shared_ptr<state>& crash_state() {
+        static std::shared_ptr<state> crashing;
+        return crashing;
+    }
+
+    static LPTOP_LEVEL_EXCEPTION_FILTER& previous_filter() {
+        static LPTOP_LEVEL_EXCEPTION_FILTER previous = nullptr;
+        return previous;
+    }
+
+    static LONG WINAPI unhandled_exception_filter(EXCEPTION_POINTERS* info) {
+        if (auto& crashing = crash_state()) {
+            crashing->stop(false);
+        }
+        return previous_filter() ? previous_filter()(info) : EXCEPTION_CONTINUE_SEARCH;
+    }
+
+    std::shared_ptr<state> _state;
+    std::unique_ptr<spdlog::formatter> _formatter;
+    std::atomic<uint32_t> _formatter_generation{ 1 };
+    std::mutex _formatter_mutex;
+};
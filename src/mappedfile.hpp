@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file. Pages are only read from disk as they're touched.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path& path)
+    {
+#if defined(_WIN32)
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+            if (HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) {
+                _data = static_cast<std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                _size = _data ? (size_t)size.QuadPart : 0;
+                CloseHandle(mapping); // The view keeps the mapping alive
+            }
+        }
+        CloseHandle(file);
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return;
+
+        struct stat info;
+        if (fstat(file, &info) == 0 && info.st_size > 0) {
+            void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (data != MAP_FAILED) {
+                _data = static_cast<std::uint8_t*>(data);
+                _size = (size_t)info.st_size;
+                madvise(data, _size, MADV_SEQUENTIAL);
+            }
+        }
+        close(file);
+#endif
+    }
+
+    ~MappedFile()
+    {
+        if (!_data)
+            return;
+#if defined(_WIN32)
+        UnmapViewOfFile(_data);
+#else
+        munmap(_data, _size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    explicit operator bool() const { return _data != nullptr; }
+
+    // Mapped read-only, writing through this faults
+    std::uint8_t* Data() const { return _data; }
+    size_t Size() const { return _size; }
+
+private:
+    std::uint8_t* _data = nullptr;
+    size_t _size = 0;
+};
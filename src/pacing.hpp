@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace Pacing
+{
+    // Paces frames to a target rate against any clock, so the same logic can be driven by a simulated clock.
+    // A Clock provides:
+    //   int64_t Now()                     Monotonic time in nanoseconds.
+    //   void SleepUntil(int64_t deadline) Coarse sleep. May wake late, should not wake much early.
+    //   void Relax()                      Called on every iteration of the spin loop.
+    //   int64_t SpinMargin() const        How long before a deadline to stop sleeping and spin instead.
+    template<typename Clock>
+    class Limiter
+    {
+    public:
+        template<typename... Args>
+        explicit Limiter(double fps, Args&&... args) : _clock(std::forward<Args>(args)...)
+        {
+            SetTarget(fps);
+        }
+
+        // 0 disables pacing, Wait() then only measures frametimes. Can be changed from another thread.
+        void SetTarget(double fps)
+        {
+            _period.store(fps > 0 ? (int64_t)std::llround(1e9 / fps) : 0, std::memory_order_relaxed);
+        }
+
+        int64_t Period() const { return _period.load(std::memory_order_relaxed); }
+        Clock& GetClock() { return _clock; }
+
+        // Call once per frame at the frame boundary.
+        // Waits until the next frame is due and returns how long the last frame took in nanoseconds (0 for the first frame).
+        int64_t Wait()
+        {
+            int64_t now = _clock.Now();
+            int64_t period = Period();
+            if (!_started) {
+                _started = true;
+                _last = now;
+                _next = now + period;
+                return 0;
+            }
+
+            if (period > 0 && now < _next) {
+                // Sleep most of the way, then spin the rest so we don't depend on when the OS wakes us
+                if (_next - now > _clock.SpinMargin())
+                    _clock.SleepUntil(_next - _clock.SpinMargin());
+                while ((now = _clock.Now()) < _next)
+                    _clock.Relax();
+            }
+
+            // Keep the cadence through small overruns, but if we're a whole frame behind start over instead of rushing to catch up
+            _next = (now - _next >= period) ? now + period : _next + period;
+
+            auto frametime = now - _last;
+            _last = now;
+            return frametime;
+        }
+
+    private:
+        Clock _clock;
+        std::atomic<int64_t> _period{ 0 };
+        int64_t _last = 0;
+        int64_t _next = 0;
+        bool _started = false;
+    };
+
+    struct Summary
+    {
+        size_t frames;
+        double averageMs;
+        double averageFps;
+        double low1Fps;     // Average of the slowest 1% of frames
+        double low01Fps;    // Average of the slowest 0.1% of frames
+        double jitterMs;    // Standard deviation of frametime
+    };
+
+    // Rolling window of the last Frames frametimes. Recording is a single store, Compute() does the sorting.
+    template<size_t Frames = 4096>
+    class FrameStats
+    {
+    public:
+        void Record(int64_t frametime)
+        {
+            if (frametime <= 0)
+                return;
+            _frametimes[_next] = (float)(frametime / 1e6);
+            _next = (_next + 1) % Frames;
+            _count = (std::min)(_count + 1, Frames);
+        }
+
+        void Reset()
+        {
+            _next = 0;
+            _count = 0;
+        }
+
+        Summary Compute()
+        {
+            Summary summary{};
+            summary.frames = _count;
+            if (_count == 0)
+                return summary;
+
+            double total = 0;
+            for (size_t i = 0; i < _count; ++i)
+                total += _frametimes[i];
+            summary.averageMs = total / _count;
+            summary.averageFps = 1000.0 / summary.averageMs;
+
+            double variance = 0;
+            for (size_t i = 0; i < _count; ++i)
+                variance += (_frametimes[i] - summary.averageMs) * (_frametimes[i] - summary.averageMs);
+            summary.jitterMs = std::sqrt(variance / _count);
+
+            summary.low1Fps = SlowestAverageFps(100);
+            summary.low01Fps = SlowestAverageFps(1000);
+            return summary;
+        }
+
+    private:
+        // Average fps over the slowest 1/fraction of frames, at least one frame
+        double SlowestAverageFps(size_t fraction)
+        {
+            size_t slowest = (std::max)(_count / fraction, (size_t)1);
+            std::copy_n(_frametimes.begin(), _count, _scratch.begin());
+            std::nth_element(_scratch.begin(), _scratch.begin() + (slowest - 1), _scratch.begin() + _count, std::greater<float>());
+
+            double total = 0;
+            for (size_t i = 0; i < slowest; ++i)
+                total += _scratch[i];
+            return 1000.0 / (total / slowest);
+        }
+
+        std::array<float, Frames> _frametimes{};
+        std::array<float, Frames> _scratch{};
+        size_t _next = 0;
+        size_t _count = 0;
+    };
+
+#if defined(_WIN32)
+    // QueryPerformanceCounter for time and a waitable timer for sleeping.
+    // Uses a high resolution timer where available (Windows 10 1803+), otherwise a regular one with a wider spin margin.
+    class WaitableTimerClock
+    {
+    public:
+        WaitableTimerClock()
+        {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            _frequency = frequency.QuadPart;
+
+            _timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+            if (!_timer) {
+                _timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+                _highResolution = false;
+                _spinMargin = 2000000;
+            }
+        }
+
+        ~WaitableTimerClock()
+        {
+            if (_timer)
+                CloseHandle(_timer);
+        }
+
+        WaitableTimerClock(const WaitableTimerClock&) = delete;
+        WaitableTimerClock& operator=(const WaitableTimerClock&) = delete;
+
+        int64_t Now() const
+        {
+            LARGE_INTEGER counter;
+            QueryPerformanceCounter(&counter);
+            // Split to avoid overflowing when converting to nanoseconds
+            return (counter.QuadPart / _frequency) * 1000000000 + (counter.QuadPart % _frequency) * 1000000000 / _frequency;
+        }
+
+        void SleepUntil(int64_t deadline)
+        {
+            auto remaining = deadline - Now();
+            if (remaining <= 0 || !_timer)
+                return;
+
+            // Negative due time is relative, in 100ns units
+            LARGE_INTEGER due;
+            due.QuadPart = -(remaining / 100);
+            if (SetWaitableTimer(_timer, &due, 0, nullptr, nullptr, FALSE))
+                WaitForSingleObject(_timer, INFINITE);
+        }
+
+        void Relax() const { YieldProcessor(); }
+        int64_t SpinMargin() const { return _spinMargin; }
+        bool HighResolution() const { return _highResolution; }
+
+    private:
+        HANDLE _timer = nullptr;
+        int64_t _frequency = 1;
+        int64_t _spinMargin = 1000000;
+        bool _highResolution = true;
+    };
+#endif
+}
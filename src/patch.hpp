@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <windows.h>
+
+namespace Memory
+{
+    // Collects writes and applies them together, changing protection once per page and flushing the instruction cache once.
+    // The bytes each write replaced are kept, so everything committed can be put back with Revert().
+    class PatchTransaction
+    {
+    public:
+        template<typename T>
+        PatchTransaction& Write(uintptr_t address, const T& value)
+        {
+            return Bytes(address, &value, sizeof(T));
+        }
+
+        PatchTransaction& Bytes(uintptr_t address, const void* bytes, size_t size)
+        {
+            std::scoped_lock lock(_mutex);
+            auto data = static_cast<const std::uint8_t*>(bytes);
+            _pending.push_back({ address, std::vector<std::uint8_t>(data, data + size), {} });
+            return *this;
+        }
+
+        // Applies every write queued since the last commit. Either all of them are written or, if a page can't be made writable, none are.
+        bool Commit()
+        {
+            std::scoped_lock lock(_mutex);
+            if (_pending.empty())
+                return true;
+
+            bool bApplied = Apply(_pending, false);
+            if (bApplied)
+                _applied.insert(_applied.end(), _pending.begin(), _pending.end());
+            _pending.clear();
+            return bApplied;
+        }
+
+        // Puts back the original bytes of everything committed, newest first so overlapping writes unwind in order
+        bool Revert()
+        {
+            std::scoped_lock lock(_mutex);
+            if (_applied.empty())
+                return true;
+
+            std::reverse(_applied.begin(), _applied.end());
+            bool bReverted = Apply(_applied, true);
+            if (bReverted)
+                _applied.clear();
+            else
+                std::reverse(_applied.begin(), _applied.end());
+            return bReverted;
+        }
+
+    private:
+        struct Patch
+        {
+            uintptr_t address;
+            std::vector<std::uint8_t> bytes;
+            std::vector<std::uint8_t> original;
+        };
+
+        std::mutex _mutex;
+        std::vector<Patch> _pending;
+        std::vector<Patch> _applied;
+
+        static bool Apply(std::vector<Patch>& patches, bool bRevert)
+        {
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            uintptr_t pageSize = info.dwPageSize;
+
+            std::vector<uintptr_t> pages;
+            uintptr_t low = UINTPTR_MAX;
+            uintptr_t high = 0;
+            for (const auto& patch : patches) {
+                for (auto page = patch.address & ~(pageSize - 1); page < patch.address + patch.bytes.size(); page += pageSize)
+                    pages.push_back(page);
+                low = (std::min)(low, patch.address);
+                high = (std::max)(high, patch.address + patch.bytes.size());
+            }
+            std::sort(pages.begin(), pages.end());
+            pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+            // Pages are changed one at a time since each can have a different protection to restore
+            std::vector<DWORD> oldProtect(pages.size());
+            size_t unprotected = 0;
+            while (unprotected < pages.size() && VirtualProtect((LPVOID)pages[unprotected], pageSize, PAGE_EXECUTE_READWRITE, &oldProtect[unprotected]))
+                ++unprotected;
+
+            bool bWritable = unprotected == pages.size();
+            if (bWritable) {
+                for (auto& patch : patches) {
+                    auto target = reinterpret_cast<std::uint8_t*>(patch.address);
+                    if (bRevert) {
+                        memcpy(target, patch.original.data(), patch.original.size());
+                    }
+                    else {
+                        patch.original.assign(target, target + patch.bytes.size());
+                        memcpy(target, patch.bytes.data(), patch.bytes.size());
+                    }
+                }
+            }
+
+            DWORD protect;
+            for (size_t i = 0; i < unprotected; ++i)
+                VirtualProtect((LPVOID)pages[i], pageSize, oldProtect[i], &protect);
+
+            if (bWritable)
+                FlushInstructionCache(GetCurrentProcess(), (LPCVOID)low, high - low);
+            return bWritable;
+        }
+    };
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "pe.hpp"
+#include "scanner.hpp"
+
+// Resolving signatures against a Pe::Image. Doesn't touch the Windows API so it also runs against an exe on disk.
+namespace Memory
+{
+    struct Signature
+    {
+        const char* name;
+        Scanner::PatternView pattern;
+        Scanner::Section section = Scanner::Section::Any;
+        // How many times the signature should match, any other count is logged as a warning. index picks the match to use, in address order.
+        size_t expected = 1;
+        size_t index = 0;
+        // A different match count fails the signature instead, for ones where using the wrong match is worse than none
+        bool bStrict = false;
+        std::uint8_t* address = nullptr;
+        // Matches found by the last scan, counted up to one more than needed
+        size_t matches = 0;
+    };
+
+    // The match a signature resolves to out of those found for it, in address order
+    inline std::uint8_t* Pick(const Signature& signature, const std::vector<std::uint8_t*>& found)
+    {
+        if (signature.bStrict && found.size() != signature.expected)
+            return nullptr;
+        return signature.index < found.size() ? found[signature.index] : nullptr;
+    }
+
+    // Returns the memory ranges of every section that can contain the given kind of signature, in address order.
+    inline std::vector<std::pair<std::uint8_t*, size_t>> GetSections(const Pe::Image& image, Scanner::Section section)
+    {
+        std::vector<std::pair<std::uint8_t*, size_t>> ranges;
+        for (const auto& range : image.Ranges(section))
+            ranges.push_back({ range.data, range.size });
+        return ranges;
+    }
+
+    // Resolves every signature with a single pass over the sections each one is tagged with.
+    // Each section is split across a pool of worker threads. Signatures that share a pattern are only scanned for once.
+    inline void PatternScan(const Pe::Image& image, const std::vector<Signature*>& signatures, unsigned int workers = Scanner::DefaultWorkers())
+    {
+        // Data covers the same ranges as Any, so they share a pass
+        for (auto section : { Scanner::Section::Any, Scanner::Section::Code }) {
+            // Signatures grouped by pattern, and how many matches each pattern needs to settle all of them
+            std::vector<std::vector<Signature*>> group;
+            std::vector<Scanner::PatternView> patterns;
+            std::vector<size_t> limits;
+            for (auto signature : signatures) {
+                if ((signature->section == Scanner::Section::Code) != (section == Scanner::Section::Code))
+                    continue;
+                signature->address = nullptr;
+                signature->matches = 0;
+
+                // One more than expected tells us a signature is ambiguous
+                size_t limit = (std::max)(signature->expected, signature->index + 1) + 1;
+                auto same = std::find_if(patterns.begin(), patterns.end(), [&](const Scanner::PatternView& pattern) {
+                    return strcmp(pattern.text, signature->pattern.text) == 0 && pattern.text[0] != '\0';
+                });
+                if (same != patterns.end()) {
+                    size_t i = same - patterns.begin();
+                    group[i].push_back(signature);
+                    limits[i] = (std::max)(limits[i], limit);
+                    continue;
+                }
+                group.push_back({ signature });
+                patterns.push_back(signature->pattern);
+                limits.push_back(limit);
+            }
+            if (group.empty())
+                continue;
+
+            Scanner::BatchScanner scanner(std::move(patterns));
+            std::vector<std::vector<std::uint8_t*>> found(group.size());
+            for (auto [scanBytes, size] : GetSections(image, section)) {
+                std::vector<size_t> remaining(group.size());
+                for (size_t i = 0; i < group.size(); ++i)
+                    remaining[i] = limits[i] - found[i].size();
+
+                auto offsets = Scanner::ParallelScanAll(scanner, scanBytes, size, remaining, workers);
+                for (size_t i = 0; i < group.size(); ++i) {
+                    for (auto offset : offsets[i])
+                        found[i].push_back(scanBytes + offset);
+                }
+            }
+
+            for (size_t i = 0; i < group.size(); ++i) {
+                for (auto signature : group[i]) {
+                    signature->matches = (std::min)(found[i].size(), (std::max)(signature->expected, signature->index + 1) + 1);
+                    signature->address = Pick(*signature, found[i]);
+                }
+            }
+        }
+    }
+
+    // Where a signature resolved in another image of the same build, such as the exe on disk
+    struct ImageMatch
+    {
+        Signature* signature;
+        uint32_t rva;
+        size_t matches;
+    };
+
+    // Resolves copies of the signatures against image and returns the RVA of each one that resolved.
+    // The signatures themselves are left alone, so this can run on another thread while they're in use.
+    inline std::vector<ImageMatch> ScanForRvas(const Pe::Image& image, const std::vector<Signature*>& signatures, unsigned int workers = Scanner::DefaultWorkers())
+    {
+        std::vector<Signature> copies;
+        copies.reserve(signatures.size());
+        for (auto signature : signatures)
+            copies.push_back(*signature);
+
+        std::vector<Signature*> pointers;
+        for (auto& copy : copies)
+            pointers.push_back(&copy);
+        PatternScan(image, pointers, workers);
+
+        std::vector<ImageMatch> found;
+        for (size_t i = 0; i < copies.size(); ++i) {
+            auto rva = copies[i].address ? image.RvaOf(copies[i].address) : Pe::npos;
+            if (rva != Pe::npos)
+                found.push_back({ signatures[i], rva, copies[i].matches });
+        }
+        return found;
+    }
+
+    // Key used to match cache entries to signatures, changes whenever a signature's name, pattern, section or expected matches do.
+    inline uint64_t SignatureKey(const Signature& signature)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const char* str) {
+            for (; *str; ++str)
+                hash = (hash ^ static_cast<std::uint8_t>(*str)) * 1099511628211ull;
+            hash = (hash ^ 0xFF) * 1099511628211ull;
+        };
+        mix(signature.name);
+        mix(signature.pattern.text);
+        hash = (hash ^ signature.expected) * 1099511628211ull;
+        hash = (hash ^ signature.index) * 1099511628211ull;
+        hash = (hash ^ signature.bStrict) * 1099511628211ull;
+        return hash ^ static_cast<uint64_t>(signature.section);
+    }
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "scanner.hpp"
+
+// Minimal PE parser that doesn't need windows.h, so the same code can read the game's image in memory
+// or its exe on disk (see tools/sigcheck). Only what signature scanning needs is parsed.
+namespace Pe
+{
+    // Loaded by the OS loader, sections sit at their RVA. Or read straight from disk, sections sit at their raw offset.
+    enum class Layout { Mapped, File };
+
+    constexpr uint32_t ScnCntCode = 0x00000020;
+    constexpr uint32_t ScnCntInitializedData = 0x00000040;
+    constexpr uint32_t ScnMemExecute = 0x20000000;
+    constexpr uint32_t ScnMemWrite = 0x80000000;
+
+    constexpr uint32_t npos = static_cast<uint32_t>(-1);
+
+    struct FileHeader
+    {
+        uint16_t machine;
+        uint16_t numberOfSections;
+        uint32_t timeDateStamp;
+        uint32_t pointerToSymbolTable;
+        uint32_t numberOfSymbols;
+        uint16_t sizeOfOptionalHeader;
+        uint16_t characteristics;
+    };
+    static_assert(sizeof(FileHeader) == 20, "IMAGE_FILE_HEADER layout changed");
+
+    struct SectionHeader
+    {
+        char name[8];
+        uint32_t virtualSize;
+        uint32_t virtualAddress;
+        uint32_t sizeOfRawData;
+        uint32_t pointerToRawData;
+        uint32_t pointerToRelocations;
+        uint32_t pointerToLinenumbers;
+        uint16_t numberOfRelocations;
+        uint16_t numberOfLinenumbers;
+        uint32_t characteristics;
+    };
+    static_assert(sizeof(SectionHeader) == 40, "IMAGE_SECTION_HEADER layout changed");
+
+    struct Section
+    {
+        std::string name;
+        uint32_t rva;
+        uint32_t virtualSize;
+        uint32_t rawOffset;
+        uint32_t rawSize;
+        uint32_t characteristics;
+
+        bool Executable() const { return (characteristics & (ScnMemExecute | ScnCntCode)) != 0; }
+        bool InitializedData() const { return !Executable() && (characteristics & ScnCntInitializedData) != 0; }
+        bool Writable() const { return (characteristics & ScnMemWrite) != 0; }
+    };
+
+    // A block of the image that can be scanned, and the RVA its first byte maps to
+    struct Range
+    {
+        std::uint8_t* data;
+        size_t size;
+        uint32_t rva;
+    };
+
+    // One entry of the x64 exception directory (.pdata). begin is always the first byte of an instruction.
+    struct Function
+    {
+        uint32_t begin;
+        uint32_t end;
+        uint32_t unwindInfo;
+    };
+    static_assert(sizeof(Function) == 12, "RUNTIME_FUNCTION layout changed");
+
+    class Image
+    {
+    public:
+        // size is how many bytes are readable from base. For a loaded module 0 trusts SizeOfImage from the headers.
+        Image(void* base, size_t size, Layout layout) : _base(static_cast<std::uint8_t*>(base)), _size(size), _layout(layout)
+        {
+            Parse();
+        }
+
+        static Image FromModule(void* module) { return Image(module, 0, Layout::Mapped); }
+
+        bool Valid() const { return _error == nullptr; }
+        const char* Error() const { return _error ? _error : ""; }
+
+        std::uint8_t* Base() const { return _base; }
+        Layout GetLayout() const { return _layout; }
+        uint16_t Machine() const { return _fileHeader.machine; }
+        uint32_t Timestamp() const { return _fileHeader.timeDateStamp; }
+        uint32_t SizeOfImage() const { return _sizeOfImage; }
+        const std::vector<Section>& Sections() const { return _sections; }
+
+        // Every block that can contain the given kind of signature, in address order
+        std::vector<Range> Ranges(Scanner::Section kind) const
+        {
+            std::vector<Range> ranges;
+            if (!Valid())
+                return ranges;
+
+            // Data can sit in any section, packed or RWX ones included, so it gets the whole image like Any
+            bool bWhole = kind != Scanner::Section::Code;
+            if (bWhole && _layout == Layout::Mapped)
+                return { { _base, _size, 0 } };
+            if (bWhole)
+                ranges.push_back({ _base, (std::min)((size_t)_sizeOfHeaders, _size), 0 });
+
+            for (const auto& section : _sections) {
+                if (kind == Scanner::Section::Code && !section.Executable())
+                    continue;
+
+                size_t offset = _layout == Layout::Mapped ? section.rva : section.rawOffset;
+                size_t size = section.virtualSize ? section.virtualSize : section.rawSize;
+                // Anything past the raw data is zero fill that only exists once loaded
+                if (_layout == Layout::File)
+                    size = (std::min)(size, (size_t)section.rawSize);
+                if (offset >= _size || size == 0)
+                    continue;
+                ranges.push_back({ _base + offset, (std::min)(size, _size - offset), section.rva });
+            }
+
+            std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) { return a.data < b.data; });
+            return ranges;
+        }
+
+        // Pointer to the byte at an RVA, or nullptr if it isn't backed by anything readable
+        std::uint8_t* At(uint32_t rva) const
+        {
+            if (!Valid())
+                return nullptr;
+            if (_layout == Layout::Mapped || rva < _sizeOfHeaders)
+                return rva < _size ? _base + rva : nullptr;
+
+            for (const auto& section : _sections) {
+                if (rva >= section.rva && rva - section.rva < section.rawSize) {
+                    size_t offset = (size_t)section.rawOffset + (rva - section.rva);
+                    return offset < _size ? _base + offset : nullptr;
+                }
+            }
+            return nullptr;
+        }
+
+        // Every function with unwind info, sorted by start. Empty for images without an exception directory (x86).
+        std::vector<Function> Functions() const
+        {
+            std::vector<Function> functions(_exceptionSize / sizeof(Function));
+            auto table = At(_exceptionRva);
+            if (functions.empty() || !table || !At(_exceptionRva + (uint32_t)(functions.size() * sizeof(Function)) - 1))
+                return {};
+
+            memcpy(functions.data(), table, functions.size() * sizeof(Function));
+            std::sort(functions.begin(), functions.end(), [](const Function& a, const Function& b) { return a.begin < b.begin; });
+            return functions;
+        }
+
+        // RVA of a pointer into the image, or npos if it isn't part of anything the loader would map
+        uint32_t RvaOf(const std::uint8_t* address) const
+        {
+            if (address < _base || address >= _base + _size)
+                return npos;
+
+            size_t offset = address - _base;
+            if (_layout == Layout::Mapped || offset < _sizeOfHeaders)
+                return (uint32_t)offset;
+
+            for (const auto& section : _sections) {
+                if (offset >= section.rawOffset && offset < (size_t)section.rawOffset + section.rawSize)
+                    return section.rva + (uint32_t)(offset - section.rawOffset);
+            }
+            return npos;
+        }
+
+        const Section* SectionAt(uint32_t rva) const
+        {
+            for (const auto& section : _sections) {
+                auto size = (std::max)(section.virtualSize, section.rawSize);
+                if (rva >= section.rva && rva < section.rva + size)
+                    return &section;
+            }
+            return nullptr;
+        }
+
+    private:
+        std::uint8_t* _base;
+        size_t _size;
+        Layout _layout;
+        FileHeader _fileHeader{};
+        uint32_t _sizeOfImage = 0;
+        uint32_t _sizeOfHeaders = 0;
+        uint32_t _exceptionRva = 0;
+        uint32_t _exceptionSize = 0;
+        std::vector<Section> _sections;
+        const char* _error = nullptr;
+
+        template<typename T>
+        bool Read(size_t offset, T& value) const
+        {
+            if (_size != 0 && (offset > _size || _size - offset < sizeof(T)))
+                return false;
+            memcpy(&value, _base + offset, sizeof(T));
+            return true;
+        }
+
+        void Parse()
+        {
+            uint16_t dosMagic = 0;
+            int32_t lfanew = 0;
+            if (!_base || !Read(0, dosMagic) || dosMagic != 0x5A4D || !Read(0x3C, lfanew) || lfanew <= 0) {
+                _error = "not an executable (no MZ header)";
+                return;
+            }
+
+            uint32_t ntSignature = 0;
+            if (!Read(lfanew, ntSignature) || ntSignature != 0x00004550 || !Read(lfanew + 4, _fileHeader)) {
+                _error = "no PE header";
+                return;
+            }
+
+            // SizeOfImage and SizeOfHeaders sit at the same offsets in PE32 and PE32+
+            size_t optionalHeader = lfanew + 4 + sizeof(FileHeader);
+            if (!Read(optionalHeader + 56, _sizeOfImage) || !Read(optionalHeader + 60, _sizeOfHeaders)) {
+                _error = "truncated optional header";
+                return;
+            }
+            if (_size == 0)
+                _size = _sizeOfImage;
+
+            // Data directories follow the fixed fields, which are 16 bytes longer in PE32+
+            constexpr size_t exceptionDirectory = 3;
+            uint16_t magic = 0;
+            uint32_t directoryCount = 0;
+            size_t directories = optionalHeader + (Read(optionalHeader, magic) && magic == 0x20B ? 112 : 96);
+            if (Read(directories - 4, directoryCount) && directoryCount > exceptionDirectory) {
+                Read(directories + exceptionDirectory * 8, _exceptionRva);
+                Read(directories + exceptionDirectory * 8 + 4, _exceptionSize);
+            }
+
+            size_t sectionTable = optionalHeader + _fileHeader.sizeOfOptionalHeader;
+            for (uint16_t i = 0; i < _fileHeader.numberOfSections; ++i) {
+                SectionHeader header;
+                if (!Read(sectionTable + i * sizeof(SectionHeader), header)) {
+                    _error = "truncated section table";
+                    return;
+                }
+                _sections.push_back({ std::string(header.name, strnlen(header.name, sizeof(header.name))), header.virtualAddress,
+                    header.virtualSize, header.pointerToRawData, header.sizeOfRawData, header.characteristics });
+            }
+        }
+    };
+}
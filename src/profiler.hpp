@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+#include <spdlog/spdlog.h>
+#include <safetyhook.hpp>
+
+namespace Profiler
+{
+    // Maximum number of hooks that can be profiled
+    constexpr size_t MaxSlots = 64;
+    // Cycle histogram buckets, bucket n counts calls that took [2^n, 2^(n+1)) cycles
+    constexpr size_t Buckets = 40;
+
+    // Counters for one hook. Padded to its own cache lines so hooks firing on different threads don't contend.
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> calls{ 0 };
+        std::atomic<uint64_t> cycles{ 0 };
+        std::array<std::atomic<uint32_t>, Buckets> histogram{};
+    };
+
+    namespace detail
+    {
+        inline std::array<Slot, MaxSlots> Slots;
+        inline std::array<safetyhook::MidHookFn, MaxSlots> Callbacks{};
+        inline std::array<const char*, MaxSlots> Names{};
+        inline size_t SlotCount = 0;
+
+        inline void Record(Slot& slot, uint64_t cycles)
+        {
+            size_t bucket = 0;
+#if defined(_MSC_VER)
+            unsigned long index;
+            if (_BitScanReverse64(&index, cycles | 1))
+                bucket = index;
+#else
+            bucket = 63 - __builtin_clzll(cycles | 1);
+#endif
+            slot.calls.fetch_add(1, std::memory_order_relaxed);
+            slot.cycles.fetch_add(cycles, std::memory_order_relaxed);
+            slot.histogram[(std::min)(bucket, Buckets - 1)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        template<size_t Index>
+        void Profiled(SafetyHookContext& ctx)
+        {
+            auto start = __rdtsc();
+            Callbacks[Index](ctx);
+            Record(Slots[Index], __rdtsc() - start);
+        }
+
+        template<size_t... Indices>
+        constexpr std::array<safetyhook::MidHookFn, MaxSlots> MakeWrappers(std::index_sequence<Indices...>)
+        {
+            return { &Profiled<Indices>... };
+        }
+
+        inline constexpr auto Wrappers = MakeWrappers(std::make_index_sequence<MaxSlots>{});
+
+        // TSC ticks per nanosecond, measured against the steady clock
+        inline double CalibrateTSC()
+        {
+            auto clockStart = std::chrono::steady_clock::now();
+            auto tscStart = __rdtsc();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            auto tscEnd = __rdtsc();
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - clockStart);
+            return elapsed.count() > 0 ? (double)(tscEnd - tscStart) / elapsed.count() : 1.0;
+        }
+    }
+
+    // Returns a callback that times the given one, or the callback itself if every slot is taken.
+    // Only wrap callbacks when profiling is enabled so that unprofiled hooks call straight into the fix.
+    inline safetyhook::MidHookFn Wrap(const char* name, safetyhook::MidHookFn callback)
+    {
+        if (detail::SlotCount >= MaxSlots) {
+            spdlog::warn("Profiling: Out of slots, {} will not be profiled.", name);
+            return callback;
+        }
+
+        auto index = detail::SlotCount++;
+        detail::Callbacks[index] = callback;
+        detail::Names[index] = name;
+        return detail::Wrappers[index];
+    }
+
+    // Logs calls/s, mean and p99 per profiled hook every interval, for as long as the game is running.
+    // Counters are reset after each summary so each line only covers the last interval.
+    inline void StartSummaryThread(std::chrono::seconds interval)
+    {
+        std::thread([interval] {
+            double ticksPerNs = detail::CalibrateTSC();
+            spdlog::info("Profiling: TSC runs at {:.3f} ticks/ns, summary every {}s for {} hook(s).", ticksPerNs, interval.count(), detail::SlotCount);
+
+            while (true) {
+                std::this_thread::sleep_for(interval);
+
+                spdlog::info("----------");
+                for (size_t i = 0; i < detail::SlotCount; ++i) {
+                    auto& slot = detail::Slots[i];
+                    auto calls = slot.calls.exchange(0, std::memory_order_relaxed);
+                    auto cycles = slot.cycles.exchange(0, std::memory_order_relaxed);
+
+                    std::array<uint32_t, Buckets> histogram{};
+                    for (size_t b = 0; b < Buckets; ++b)
+                        histogram[b] = slot.histogram[b].exchange(0, std::memory_order_relaxed);
+
+                    if (calls == 0) {
+                        spdlog::info("Profiling: {}: 0 calls/s", detail::Names[i]);
+                        continue;
+                    }
+
+                    // p99 is reported as the upper bound of the bucket it lands in
+                    uint64_t target = calls - calls / 100;
+                    uint64_t seen = 0;
+                    size_t p99Bucket = 0;
+                    for (; p99Bucket < Buckets; ++p99Bucket) {
+                        seen += histogram[p99Bucket];
+                        if (seen >= target)
+                            break;
+                    }
+
+                    double mean = (double)cycles / calls / ticksPerNs;
+                    double p99 = (double)(2ull << (std::min)(p99Bucket, Buckets - 1)) / ticksPerNs;
+                    spdlog::info("Profiling: {}: {:.1f} calls/s, mean {:.0f}ns, p99 <{:.0f}ns", detail::Names[i], (double)calls / interval.count(), mean, p99);
+                }
+                spdlog::info("----------");
+            }
+        }).detach();
+    }
+}
@@ -0,0 +1,605 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define SCANNER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SCANNER_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define SCANNER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define SCANNER_X86 0
+#endif
+
+namespace Scanner
+{
+    constexpr size_t npos = static_cast<size_t>(-1);
+
+    // Which sections of the image a signature should be searched in.
+    // Code covers executable sections. Data covers the whole image like Any, since data can be in any section.
+    enum class Section { Any, Code, Data };
+
+    namespace detail
+    {
+        // Rough byte frequencies in x64 code, higher is more common. Used to pick the rarest literal bytes
+        // of a pattern as prefilter anchors so that as few candidates as possible need a full compare.
+        constexpr std::array<std::uint8_t, 256> ByteFrequency = [] {
+            std::array<std::uint8_t, 256> freq{};
+            for (auto& f : freq)
+                f = 1;
+
+            constexpr std::uint8_t veryCommon[] = { 0x00, 0xFF, 0x48, 0x89, 0x8B, 0x0F, 0xCC };
+            constexpr std::uint8_t common[] = { 0x24, 0x44, 0x4C, 0x41, 0x45, 0x49, 0x4D, 0x85, 0x83, 0x8D, 0xE8,
+                0xF3, 0x10, 0x11, 0x28, 0x01, 0x74, 0x75, 0xC0, 0xC3, 0x33, 0x20, 0x40, 0x08, 0x90, 0xEB };
+            constexpr std::uint8_t uncommon[] = { 0x02, 0x03, 0x04, 0x05, 0x18, 0x30, 0x38, 0x50, 0x58, 0x59, 0x5B,
+                0x5C, 0x5D, 0x5E, 0x5F, 0x66, 0x80, 0x84, 0x87, 0x8A, 0xB6, 0xC1, 0xC6, 0xC7, 0xC9, 0xD2, 0xE9, 0xF0,
+                0xF2, 0xF6, 0xF8, 0x0C, 0x14, 0x1C, 0x3B, 0x39, 0x57, 0x56, 0x55, 0x53 };
+
+            for (auto b : uncommon)
+                freq[b] = 4;
+            for (auto b : common)
+                freq[b] = 8;
+            for (auto b : veryCommon)
+                freq[b] = 16;
+            return freq;
+        }();
+
+        struct Anchors
+        {
+            // Two rarest literal bytes, used by the SIMD prefilter. Both are the same if there is only one literal.
+            size_t rare = npos;
+            size_t rare2 = npos;
+        };
+
+        constexpr Anchors SelectAnchors(const std::uint8_t* bytes, const std::uint8_t* mask, size_t length)
+        {
+            Anchors anchors;
+            for (size_t i = 0; i < length; ++i) {
+                if (mask[i] == 0x00)
+                    continue;
+
+                if (anchors.rare == npos || ByteFrequency[bytes[i]] < ByteFrequency[bytes[anchors.rare]]) {
+                    anchors.rare2 = anchors.rare;
+                    anchors.rare = i;
+                }
+                else if (anchors.rare2 == npos || ByteFrequency[bytes[i]] < ByteFrequency[bytes[anchors.rare2]]) {
+                    anchors.rare2 = i;
+                }
+            }
+            if (anchors.rare2 == npos)
+                anchors.rare2 = anchors.rare;
+            return anchors;
+        }
+    }
+
+    // Non-owning view of a parsed signature and the anchors chosen for it.
+    // Wildcard bytes have a mask of 0x00, literal bytes 0xFF.
+    struct PatternView
+    {
+        const std::uint8_t* bytes = nullptr;
+        const std::uint8_t* mask = nullptr;
+        size_t length = 0;
+        detail::Anchors anchors;
+        const char* text = "";
+        // Full compare, specialized on the pattern for signatures compiled with Sig<>
+        bool (*matches)(const std::uint8_t* data, const PatternView& pattern) = nullptr;
+
+        constexpr size_t size() const { return length; }
+    };
+
+    namespace detail
+    {
+        inline bool MatchesMasked(const std::uint8_t* data, const PatternView& pattern)
+        {
+            size_t i = 0;
+#if SCANNER_X86
+            // Full masked compare, 16 bytes at a time
+            for (; i + 16 <= pattern.size(); i += 16) {
+                auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                auto mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern.mask + i));
+                auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern.bytes + i));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(chunk, mask), bytes)) != 0xFFFF)
+                    return false;
+            }
+#endif
+            for (; i < pattern.size(); ++i) {
+                if ((data[i] & pattern.mask[i]) != pattern.bytes[i])
+                    return false;
+            }
+            return true;
+        }
+    }
+
+    inline bool Matches(const std::uint8_t* data, const PatternView& pattern)
+    {
+        return pattern.matches(data, pattern);
+    }
+
+    // Signature parsed at runtime, for patterns that aren't known at compile time.
+    struct Pattern
+    {
+        std::vector<std::uint8_t> bytes;
+        std::vector<std::uint8_t> mask;
+
+        size_t size() const { return bytes.size(); }
+
+        PatternView View() const
+        {
+            return { bytes.data(), mask.data(), bytes.size(), detail::SelectAnchors(bytes.data(), mask.data(), bytes.size()), "", &detail::MatchesMasked };
+        }
+
+        operator PatternView() const { return View(); }
+    };
+
+    // Based on CSGOSimple's pattern_to_byte
+    // https://github.com/OneshotGH/CSGOSimple-master/blob/master/CSGOSimple/helpers/utils.cpp
+    inline Pattern Parse(const char* signature)
+    {
+        Pattern pattern;
+        auto start = const_cast<char*>(signature);
+        auto end = const_cast<char*>(signature) + strlen(signature);
+
+        for (auto current = start; current < end; ++current) {
+            if (*current == ' ')
+                continue;
+
+            if (*current == '?') {
+                if (current + 1 < end && *(current + 1) == '?')
+                    ++current;
+                pattern.bytes.push_back(0x00);
+                pattern.mask.push_back(0x00);
+            }
+            else {
+                pattern.bytes.push_back(static_cast<std::uint8_t>(strtoul(current, &current, 16)));
+                pattern.mask.push_back(0xFF);
+                --current;
+            }
+        }
+        return pattern;
+    }
+
+    // String literal usable as a template argument.
+    template<size_t N>
+    struct FixedString
+    {
+        char value[N]{};
+
+        consteval FixedString(const char (&str)[N])
+        {
+            for (size_t i = 0; i < N; ++i)
+                value[i] = str[i];
+        }
+    };
+
+    // Signature parsed at compile time into fixed-size byte and mask arrays.
+    // A malformed signature fails to compile.
+    template<size_t N>
+    struct FixedPattern
+    {
+        // Every byte takes at least one character plus a separator
+        static constexpr size_t capacity = N / 2;
+
+        std::array<std::uint8_t, capacity> bytes{};
+        std::array<std::uint8_t, capacity> mask{};
+        size_t length = 0;
+        detail::Anchors anchors;
+
+        consteval FixedPattern(const char (&signature)[N])
+        {
+            auto hexValue = [](char c) -> int {
+                if (c >= '0' && c <= '9') return c - '0';
+                if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+                if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+                return -1;
+            };
+
+            size_t i = 0;
+            while (i < N - 1) {
+                if (signature[i] == ' ') {
+                    ++i;
+                    continue;
+                }
+
+                size_t tokenEnd = i;
+                while (tokenEnd < N - 1 && signature[tokenEnd] != ' ')
+                    ++tokenEnd;
+
+                if ((tokenEnd - i == 1 && signature[i] == '?') || (tokenEnd - i == 2 && signature[i] == '?' && signature[i + 1] == '?')) {
+                    bytes[length] = 0x00;
+                    mask[length] = 0x00;
+                }
+                else if (tokenEnd - i == 2 && hexValue(signature[i]) >= 0 && hexValue(signature[i + 1]) >= 0) {
+                    bytes[length] = static_cast<std::uint8_t>(hexValue(signature[i]) * 16 + hexValue(signature[i + 1]));
+                    mask[length] = 0xFF;
+                }
+                else {
+                    throw "Malformed signature: bytes must be two hex digits or ?/?? separated by spaces";
+                }
+                ++length;
+                i = tokenEnd;
+            }
+
+            if (length == 0)
+                throw "Malformed signature: empty";
+
+            anchors = detail::SelectAnchors(bytes.data(), mask.data(), length);
+        }
+    };
+
+    template<FixedString Signature>
+    inline constexpr FixedPattern<sizeof(Signature.value)> Compiled{ Signature.value };
+
+    namespace detail
+    {
+        // Full compare with the length and every byte known at compile time
+        template<FixedString Signature>
+        bool MatchesCompiled(const std::uint8_t* data, const PatternView&)
+        {
+            constexpr auto& pattern = Compiled<Signature>;
+            for (size_t i = 0; i < pattern.length; ++i) {
+                if ((data[i] & pattern.mask[i]) != pattern.bytes[i])
+                    return false;
+            }
+            return true;
+        }
+    }
+
+    // Compile-time signature, e.g. Scanner::Sig<"F3 0F ?? ??">.
+    template<FixedString Signature>
+    inline constexpr PatternView Sig = { Compiled<Signature>.bytes.data(), Compiled<Signature>.mask.data(),
+        Compiled<Signature>.length, Compiled<Signature>.anchors, Signature.value, &detail::MatchesCompiled<Signature> };
+
+    enum class Kernel { Scalar, SSE2, AVX2 };
+
+    inline const char* KernelName(Kernel kernel)
+    {
+        switch (kernel) {
+        case Kernel::AVX2: return "AVX2";
+        case Kernel::SSE2: return "SSE2";
+        default: return "Scalar";
+        }
+    }
+
+    // Picks the widest scan kernel the CPU (and OS) supports. Cached after the first call.
+    inline Kernel DetectKernel()
+    {
+        static const Kernel kernel = [] {
+#if SCANNER_X86
+            int regs[4] = {};
+#if defined(_MSC_VER)
+            __cpuid(regs, 1);
+#else
+            __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+            bool bSSE2 = (regs[3] & (1 << 26)) != 0;
+            bool bOSXSAVE = (regs[2] & (1 << 27)) != 0;
+            bool bAVX = (regs[2] & (1 << 28)) != 0;
+
+            bool bAVX2 = false;
+            if (bOSXSAVE && bAVX) {
+#if defined(_MSC_VER)
+                unsigned long long xcr0 = _xgetbv(0);
+                __cpuidex(regs, 7, 0);
+#else
+                unsigned int xcr0Low, xcr0High;
+                __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+                unsigned long long xcr0 = ((unsigned long long)xcr0High << 32) | xcr0Low;
+                __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+                // OS must save both XMM and YMM state
+                bAVX2 = (xcr0 & 0x6) == 0x6 && (regs[1] & (1 << 5)) != 0;
+            }
+
+            if (bAVX2)
+                return Kernel::AVX2;
+            if (bSSE2)
+                return Kernel::SSE2;
+#endif
+            return Kernel::Scalar;
+        }();
+        return kernel;
+    }
+
+    namespace detail
+    {
+        inline size_t FindScalar(const std::uint8_t* data, size_t size, const PatternView& pattern, size_t start, size_t anchor)
+        {
+            auto anchorByte = pattern.bytes[anchor];
+            for (size_t i = start; i + pattern.size() <= size; ++i) {
+                if (data[i + anchor] == anchorByte && Matches(data + i, pattern))
+                    return i;
+            }
+            return npos;
+        }
+
+#if SCANNER_X86
+        inline size_t FindSSE2(const std::uint8_t* data, size_t size, const PatternView& pattern, size_t first, size_t second)
+        {
+            auto firstByte = _mm_set1_epi8(static_cast<char>(pattern.bytes[first]));
+            auto secondByte = _mm_set1_epi8(static_cast<char>(pattern.bytes[second]));
+            size_t reach = (std::max)(first, second) + 16;
+
+            size_t i = 0;
+            for (; i + reach <= size; i += 16) {
+                auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + first));
+                auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + second));
+                auto candidates = static_cast<unsigned int>(
+                    _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, firstByte), _mm_cmpeq_epi8(b, secondByte))));
+
+                while (candidates) {
+#if defined(_MSC_VER)
+                    unsigned long bit;
+                    _BitScanForward(&bit, candidates);
+#else
+                    unsigned int bit = __builtin_ctz(candidates);
+#endif
+                    if (i + bit + pattern.size() <= size && Matches(data + i + bit, pattern))
+                        return i + bit;
+                    candidates &= candidates - 1;
+                }
+            }
+            return FindScalar(data, size, pattern, i, first);
+        }
+
+        SCANNER_TARGET_AVX2 inline size_t FindAVX2(const std::uint8_t* data, size_t size, const PatternView& pattern, size_t first, size_t second)
+        {
+            auto firstByte = _mm256_set1_epi8(static_cast<char>(pattern.bytes[first]));
+            auto secondByte = _mm256_set1_epi8(static_cast<char>(pattern.bytes[second]));
+            size_t reach = (std::max)(first, second) + 32;
+
+            size_t i = 0;
+            for (; i + reach <= size; i += 32) {
+                auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + first));
+                auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + second));
+                auto candidates = static_cast<unsigned int>(
+                    _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, firstByte), _mm256_cmpeq_epi8(b, secondByte))));
+
+                while (candidates) {
+#if defined(_MSC_VER)
+                    unsigned long bit;
+                    _BitScanForward(&bit, candidates);
+#else
+                    unsigned int bit = __builtin_ctz(candidates);
+#endif
+                    if (i + bit + pattern.size() <= size && Matches(data + i + bit, pattern))
+                        return i + bit;
+                    candidates &= candidates - 1;
+                }
+            }
+            return FindScalar(data, size, pattern, i, first);
+        }
+#endif
+    }
+
+    // Returns the offset of the first match in [data, data + size) or npos.
+    inline size_t Find(const std::uint8_t* data, size_t size, const PatternView& pattern, Kernel kernel = DetectKernel())
+    {
+        if (pattern.size() == 0 || pattern.size() > size)
+            return npos;
+
+        auto first = pattern.anchors.rare;
+        auto second = pattern.anchors.rare2;
+        if (first == npos)
+            return 0; // All wildcards
+
+        switch (kernel) {
+#if SCANNER_X86
+        case Kernel::AVX2:
+            return detail::FindAVX2(data, size, pattern, first, second);
+        case Kernel::SSE2:
+            return detail::FindSSE2(data, size, pattern, first, second);
+#endif
+        default:
+            return detail::FindScalar(data, size, pattern, 0, first);
+        }
+    }
+
+    // Resolves a whole set of patterns in a single pass over memory.
+    // The data is walked in chunks small enough to stay in cache, and each chunk is searched for every pattern with
+    // the SIMD kernel while it's hot. Faster than walking a multi-pattern automaton a byte at a time (see tools/scanbench).
+    class BatchScanner
+    {
+    public:
+        explicit BatchScanner(std::vector<PatternView> patterns, Kernel kernel = DetectKernel()) : _patterns(std::move(patterns)), _kernel(kernel) {}
+
+        size_t Count() const { return _patterns.size(); }
+
+        size_t LongestPattern() const
+        {
+            size_t longest = 0;
+            for (const auto& pattern : _patterns)
+                longest = (std::max)(longest, pattern.size());
+            return longest;
+        }
+
+        // Returns the offset of the first match for each pattern, or npos if it was not found.
+        std::vector<size_t> Scan(const std::uint8_t* data, size_t size) const
+        {
+            return Scan(data, size, std::vector<bool>(_patterns.size(), true));
+        }
+
+        // Same as above but only looks for the patterns marked as pending, the rest are left as npos.
+        std::vector<size_t> Scan(const std::uint8_t* data, size_t size, const std::vector<bool>& pending) const
+        {
+            std::vector<size_t> limits(_patterns.size());
+            for (size_t i = 0; i < limits.size(); ++i)
+                limits[i] = pending[i] ? 1 : 0;
+
+            auto matches = ScanAll(data, size, limits);
+            std::vector<size_t> results(_patterns.size(), npos);
+            for (size_t i = 0; i < results.size(); ++i) {
+                if (!matches[i].empty())
+                    results[i] = matches[i].front();
+            }
+            return results;
+        }
+
+        // Returns the offsets of up to limits[i] matches for each pattern in address order, a limit of 0 skips the pattern.
+        // Only matches that start before end are reported, so that overlapping blocks don't report the same match twice.
+        std::vector<std::vector<size_t>> ScanAll(const std::uint8_t* data, size_t size, const std::vector<size_t>& limits, size_t end = npos) const
+        {
+            // Fits in L2 on anything the game runs on
+            constexpr size_t chunkSize = 256 * 1024;
+
+            std::vector<std::vector<size_t>> results(_patterns.size());
+            end = (std::min)(end, size);
+
+            for (size_t chunk = 0; chunk < end; chunk += chunkSize) {
+                size_t chunkEnd = (std::min)(end, chunk + chunkSize);
+
+                bool bAnyPending = false;
+                for (size_t i = 0; i < _patterns.size(); ++i) {
+                    const auto& pattern = _patterns[i];
+                    if (results[i].size() >= limits[i] || pattern.size() == 0)
+                        continue;
+                    bAnyPending = true;
+
+                    // Matches that start in this chunk can run on past it
+                    size_t searchEnd = (std::min)(size, chunkEnd + pattern.size() - 1);
+                    for (size_t offset = chunk; offset < searchEnd && results[i].size() < limits[i];) {
+                        auto match = Find(data + offset, searchEnd - offset, pattern, _kernel);
+                        if (match == npos)
+                            break;
+                        results[i].push_back(offset + match);
+                        offset += match + 1;
+                    }
+                }
+                if (!bAnyPending)
+                    break;
+            }
+            return results;
+        }
+
+    private:
+        std::vector<PatternView> _patterns;
+        Kernel _kernel;
+    };
+
+    inline unsigned int DefaultWorkers()
+    {
+        return std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+    }
+
+    // Splits [data, data + size) into blocks that overlap by the longest pattern length - 1 and scans them
+    // on a pool of worker threads. Workers take blocks in address order and skip patterns that already have a
+    // match at a lower address, so the lowest matching offset always wins and results are identical to a serial Scan.
+    inline std::vector<size_t> ParallelScan(const BatchScanner& scanner, const std::uint8_t* data, size_t size,
+        const std::vector<bool>& pending, unsigned int workers = DefaultWorkers())
+    {
+        constexpr size_t minBlockSize = 1024 * 1024;
+
+        workers = (std::max)(workers, 1u);
+        if (workers == 1 || size <= minBlockSize)
+            return scanner.Scan(data, size, pending);
+
+        size_t blockSize = (std::max)(minBlockSize, size / (workers * 4));
+        size_t blocks = (size + blockSize - 1) / blockSize;
+        size_t overlap = scanner.LongestPattern() > 0 ? scanner.LongestPattern() - 1 : 0;
+
+        std::vector<std::atomic<size_t>> best(scanner.Count());
+        for (auto& offset : best)
+            offset = npos;
+
+        std::atomic<size_t> nextBlock = 0;
+        auto worker = [&] {
+            std::vector<bool> blockPending(scanner.Count());
+            for (size_t block = nextBlock++; block < blocks; block = nextBlock++) {
+                size_t begin = block * blockSize;
+                size_t end = (std::min)(size, begin + blockSize + overlap);
+
+                bool bAnyPending = false;
+                for (size_t i = 0; i < blockPending.size(); ++i) {
+                    blockPending[i] = pending[i] && best[i].load(std::memory_order_relaxed) > begin;
+                    bAnyPending |= blockPending[i];
+                }
+                // Every pattern already matched before this block, later blocks can't do any better.
+                if (!bAnyPending)
+                    return;
+
+                auto offsets = scanner.Scan(data + begin, end - begin, blockPending);
+                for (size_t i = 0; i < offsets.size(); ++i) {
+                    if (offsets[i] == npos)
+                        continue;
+
+                    size_t offset = begin + offsets[i];
+                    size_t current = best[i].load(std::memory_order_relaxed);
+                    while (offset < current && !best[i].compare_exchange_weak(current, offset, std::memory_order_relaxed)) {}
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        unsigned int threadCount = static_cast<unsigned int>((std::min)(static_cast<size_t>(workers), blocks));
+        threads.reserve(threadCount);
+        for (unsigned int i = 0; i < threadCount; ++i)
+            threads.emplace_back(worker);
+        for (auto& thread : threads)
+            thread.join();
+
+        std::vector<size_t> results(scanner.Count());
+        for (size_t i = 0; i < results.size(); ++i)
+            results[i] = best[i];
+        return results;
+    }
+
+    // Same as ParallelScan but collects up to limits[i] matches per pattern in address order, see BatchScanner::ScanAll.
+    // Every block is scanned since a pattern's later matches can be anywhere.
+    inline std::vector<std::vector<size_t>> ParallelScanAll(const BatchScanner& scanner, const std::uint8_t* data, size_t size,
+        const std::vector<size_t>& limits, unsigned int workers = DefaultWorkers())
+    {
+        constexpr size_t minBlockSize = 1024 * 1024;
+
+        workers = (std::max)(workers, 1u);
+        if (workers == 1 || size <= minBlockSize)
+            return scanner.ScanAll(data, size, limits);
+
+        size_t blockSize = (std::max)(minBlockSize, size / (workers * 4));
+        size_t blocks = (size + blockSize - 1) / blockSize;
+        size_t overlap = scanner.LongestPattern() > 0 ? scanner.LongestPattern() - 1 : 0;
+
+        std::vector<std::vector<std::vector<size_t>>> blockResults(blocks);
+        std::atomic<size_t> nextBlock = 0;
+        auto worker = [&] {
+            for (size_t block = nextBlock++; block < blocks; block = nextBlock++) {
+                size_t begin = block * blockSize;
+                size_t end = (std::min)(size, begin + blockSize + overlap);
+                // Matches starting in the overlap belong to the next block
+                blockResults[block] = scanner.ScanAll(data + begin, end - begin, limits, blockSize);
+                for (auto& offsets : blockResults[block]) {
+                    for (auto& offset : offsets)
+                        offset += begin;
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        unsigned int threadCount = static_cast<unsigned int>((std::min)(static_cast<size_t>(workers), blocks));
+        threads.reserve(threadCount);
+        for (unsigned int i = 0; i < threadCount; ++i)
+            threads.emplace_back(worker);
+        for (auto& thread : threads)
+            thread.join();
+
+        std::vector<std::vector<size_t>> results(scanner.Count());
+        for (const auto& block : blockResults) {
+            for (size_t i = 0; i < results.size(); ++i) {
+                for (size_t j = 0; j < block[i].size() && results[i].size() < limits[i]; ++j)
+                    results[i].push_back(block[i][j]);
+            }
+        }
+        return results;
+    }
+}
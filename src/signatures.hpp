@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+#include "patternscan.hpp"
+
+// Every signature the fix uses, shared with tools/sigcheck so new game builds can be checked without launching the game
+
+// Resolution
+inline Memory::Signature ResolutionList1Sig = { "Custom Resolution: List 1", Scanner::Sig<"00 05 00 00 D0 02 00 00 56 05 00 00">, Scanner::Section::Data }; // Deferred, see Resolution()
+inline Memory::Signature CurrentResolutionSig = { "Current Resolution", Scanner::Sig<"89 ?? ?? 89 ?? ?? 48 ?? ?? ?? 89 ?? ?? 89 ?? ?? 48 ?? ?? ?? 74 ?? FF ?? ?? ?? ?? ??">, Scanner::Section::Code };
+inline Memory::Signature ResolutionList2Sig = { "Custom Resolution: List 2", Scanner::Sig<"00 05 D0 02 56 05 00 03 40 06">, Scanner::Section::Data }; // Deferred, see Resolution()
+inline Memory::Signature SystemMetricsSig = { "Custom Resolution: GetSystemMetrics", Scanner::Sig<"89 ?? ?? ?? ?? ?? FF ?? ?? ?? ?? ?? 89 ?? ?? ?? ?? ?? 48 89 ?? ?? ?? ?? ?? ?? ?? ?? 48 89 ?? ?? 89 ?? ??">, Scanner::Section::Code };
+inline Memory::Signature ResCheckSig = { "Custom Resolution: GetSystemMetrics: ResCheck", Scanner::Sig<"74 ?? 3B ?? ?? 77 ?? 3B ?? 0F ?? ?? ?? ?? ?? FF ?? 48 ?? ?? ??">, Scanner::Section::Code };
+// Intro skip
+inline Memory::Signature OpeningStateSig = { "Intro Skip: Opening State", Scanner::Sig<"48 ?? ?? 83 ?? 0E 0F 87 ?? ?? ?? ?? 48 ?? ?? ?? ?? 48 ?? ?? ?? ?? ?? ??">, Scanner::Section::Code };
+// Aspect ratio + FOV
+inline Memory::Signature CullingMarkersAspectSig = { "Aspect Ratio: Markers/Culling", Scanner::Sig<"8B ?? ?? ?? ?? ?? 48 ?? ?? 89 ?? ?? ?? ?? ?? 66 ?? ?? ?? ?? ?? ?? 00 01">, Scanner::Section::Code };
+inline Memory::Signature GameplayFOVSig = { "FOV: Gameplay", Scanner::Sig<"F3 0F ?? ?? 78 ?? ?? ?? 0F ?? ?? F3 0F ?? ?? E8 ?? ?? ?? ?? 85 ?? 75 ?? F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ??">, Scanner::Section::Code };
+inline Memory::Signature CutsceneFOVSig = { "FOV: Cutscene", Scanner::Sig<"00 0F 84 ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? 0F ?? ?? ?? ?? 0F ?? ?? ?? ?? 0F ?? ??">, Scanner::Section::Code };
+// HUD
+inline Memory::Signature HUDSizeSig = { "HUD: Size", Scanner::Sig<"45 ?? ?? 75 ?? 0F 28 ?? ?? ?? ?? ?? 0F ?? ?? F2 0F ?? ?? ?? ?? ?? ?? 33 ??">, Scanner::Section::Code };
+inline Memory::Signature MinimapPositionSig = { "HUD: Minimap Position", Scanner::Sig<"F3 0F ?? ?? ?? 0F ?? ?? 76 ?? F3 0F ?? ?? EB ?? F3 0F ?? ?? f3 0F ?? ?? 89 ?? ?? ?? 45 ?? ??">, Scanner::Section::Code };
+inline Memory::Signature KeyGuide1Sig = { "HUD: Key Guide: 1", Scanner::Sig<"F3 0F ?? ?? ?? ?? ?? ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? E8 ?? ?? ?? ??">, Scanner::Section::Code };
+inline Memory::Signature KeyGuide2Sig = { "HUD: Key Guide: 2", Scanner::Sig<"0F ?? ?? 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ??">, Scanner::Section::Code };
+inline Memory::Signature KeyGuide3Sig = { "HUD: Key Guide: 3", Scanner::Sig<"F3 0F ?? ?? ?? ?? ?? ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? 48 8B ?? ?? ??">, Scanner::Section::Code };
+inline Memory::Signature ButtonHeight1Sig = { "HUD: Button Height: 1", Scanner::Sig<"F3 0F ?? ?? ?? ?? ?? ?? 0F 28 ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 44 ?? ?? ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ??">, Scanner::Section::Code };
+inline Memory::Signature ButtonHeight2Sig = { "HUD: Button Height: 2", Scanner::Sig<"F3 0F ?? ?? ?? ?? ?? ?? 0F 28 ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 44 ?? ?? ?? 0F 28 ?? F3 0F ?? ?? ?? ?? ?? ?? 44 ?? ?? ?? ?? ?? ??">, Scanner::Section::Code };
+inline Memory::Signature MenuSelectionsSig = { "HUD: Menu Selections", Scanner::Sig<"F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? 83 ?? ?? 7C ?? F3 0F ?? ?? ?? ?? ?? ?? EB ??">, Scanner::Section::Code };
+inline Memory::Signature MinimapIconsSig = { "HUD: Minimap Icons", Scanner::Sig<"F3 41 ?? ?? ?? ?? F3 41 ?? ?? ?? ?? F3 44 ?? ?? ?? F3 44 ?? ?? ?? 0F ?? ?? ?? 0F 83 ?? ?? ?? ??">, Scanner::Section::Code };
+inline Memory::Signature GameplayHUDSig = { "HUD: Gameplay HUD", Scanner::Sig<"F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? 66 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? ?? ?? F3 0F ?? ?? ?? ?? F3 0F ?? ??">, Scanner::Section::Code };
+inline Memory::Signature MovieStateSig = { "HUD: Movie State", Scanner::Sig<"4C ?? ?? 83 ?? 16 0F 87 ?? ?? ?? ?? 48 8D ?? ?? ?? ?? ??">, Scanner::Section::Code };
+inline Memory::Signature FadesSig = { "HUD: Fades", Scanner::Sig<"8B ?? ?? ?? ?? 00 89 ?? ?? 49 ?? ?? ?? 48 ?? ?? FF ?? ?? ?? ?? 00">, Scanner::Section::Code };
+inline Memory::Signature ScreenSizeSig = { "HUD: Screen Size", Scanner::Sig<"41 ?? ?? ?? 80 ?? ?? ?? 00 41 ?? 01 00 00 00 F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ??">, Scanner::Section::Code };
+inline Memory::Signature GrowthMapSig = { "HUD: Growth Map", Scanner::Sig<"F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? 66 ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? 66 0F ?? ?? ?? ?? ?? ??">, Scanner::Section::Code, 2, 0 }; // Same code as the soul map, first match
+inline Memory::Signature SoulMapSig = { "HUD: Soul Map", Scanner::Sig<"F3 0F ?? ?? ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? 66 ?? ?? ?? ?? 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? ?? ?? ?? ?? F3 0F ?? ?? 66 0F ?? ?? ?? ?? ?? ??">, Scanner::Section::Code, 2, 1 }; // Second match
+inline Memory::Signature MissionSelect1Sig = { "HUD: Mission Select: 1", Scanner::Sig<"F3 0F ?? ?? F3 41 ?? ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? F3 0F ?? ?? ?? ?? F3 0F ?? ?? ?? ?? 0F 28 ?? ?? ??">, Scanner::Section::Code };
+inline Memory::Signature MissionSelect2Sig = { "HUD: Mission Select: 2", Scanner::Sig<"0F ?? ?? F3 41 ?? ?? ?? 66 0F ?? ?? 41 0F ?? ?? ?? 0F ?? ?? F3 0F ?? ?? F3 0F ?? ??">, Scanner::Section::Code };
+// Framerate
+inline Memory::Signature FramerateCapSig = { "Framerate Cap", Scanner::Sig<"B8 3C 00 00 00 83 ?? 02 0F ?? ?? 8D ?? ?? 85 ?? 74 ?? 85 ??">, Scanner::Section::Code };
+// Misc
+inline Memory::Signature ShadowQuality1Sig = { "Shadow Quality: 1", Scanner::Sig<"00 10 00 00 00 10 00 00 4E 00 00 00 00 04 00 00">, Scanner::Section::Data };
+inline Memory::Signature ShadowQuality2Sig = { "Shadow Quality: 2", Scanner::Sig<"BA 00 10 00 00 44 ?? ?? EB ?? BA 00 08 00 00">, Scanner::Section::Code };
+inline Memory::Signature RenderTextures1Sig = { "HUD: Render Textures: 1", Scanner::Sig<"45 ?? ?? 44 ?? ?? ?? 41 0F ?? ?? 45 ?? ?? 75 ?? 44 ?? ?? ?? ?? ?? ?? EB ??">, Scanner::Section::Code };
+inline Memory::Signature RenderTextures2Sig = { "HUD: Render Textures: 2", Scanner::Sig<"45 ?? ?? 44 ?? ?? ?? ?? 4C ?? ?? ?? 49 ?? ?? 44 ?? ?? ?? ??">, Scanner::Section::Code };
+
+inline std::vector<Memory::Signature*> Signatures = {
+    &CurrentResolutionSig, &SystemMetricsSig, &ResCheckSig,
+    &OpeningStateSig,
+    &CullingMarkersAspectSig, &GameplayFOVSig, &CutsceneFOVSig,
+    &HUDSizeSig, &MinimapPositionSig, &KeyGuide1Sig, &KeyGuide2Sig, &KeyGuide3Sig, &ButtonHeight1Sig, &ButtonHeight2Sig, &MenuSelectionsSig, &MinimapIconsSig, &GameplayHUDSig, &MovieStateSig, &FadesSig, &ScreenSizeSig, &GrowthMapSig, &SoulMapSig, &MissionSelect1Sig, &MissionSelect2Sig,
+    &FramerateCapSig,
+    &ShadowQuality1Sig, &ShadowQuality2Sig, &RenderTextures1Sig, &RenderTextures2Sig,
+};
+
+// Resolved later by Memory::WatchSignature since they may not be in memory yet when the fix starts
+inline std::vector<Memory::Signature*> DeferredSignatures = {
+    &ResolutionList1Sig, &ResolutionList2Sig,
+};
@@ -8,4 +8,6 @@
 #include <iostream>
 #include <inttypes.h>
 #include <filesystem>
-#include <string>
\ No newline at end of file
+#include <functional>
+#include <string>
+#include <unordered_map>
\ No newline at end of file
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <windows.h>
+
+#include <spdlog/spdlog.h>
+#include <safetyhook.hpp>
+
+#include "profiler.hpp"
+#include "traceformat.hpp"
+
+namespace Trace
+{
+    // Maximum number of hooks that can be traced
+    constexpr size_t MaxSlots = 64;
+    // Frames kept in the ring, about 4.5 minutes at 60fps
+    constexpr size_t Capacity = 16384;
+
+    namespace detail
+    {
+        struct alignas(64) Slot
+        {
+            std::atomic<uint32_t> calls{ 0 };
+            std::atomic<uint32_t> ticks{ 0 };
+        };
+
+        inline std::array<Slot, MaxSlots> Slots;
+        inline std::array<safetyhook::MidHookFn, MaxSlots> Callbacks{};
+        inline std::array<const char*, MaxSlots> Names{};
+        inline size_t SlotCount = 0;
+
+        template<size_t Index>
+        void Traced(SafetyHookContext& ctx)
+        {
+            auto start = __rdtsc();
+            Callbacks[Index](ctx);
+            Slots[Index].ticks.fetch_add((uint32_t)(__rdtsc() - start), std::memory_order_relaxed);
+            Slots[Index].calls.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        template<size_t... Indices>
+        constexpr std::array<safetyhook::MidHookFn, MaxSlots> MakeWrappers(std::index_sequence<Indices...>)
+        {
+            return { &Traced<Indices>... };
+        }
+
+        inline constexpr auto Wrappers = MakeWrappers(std::make_index_sequence<MaxSlots>{});
+
+        // Frame records, allocated once by Start() so capturing never allocates
+        inline std::unique_ptr<uint8_t[]> Ring;
+        inline size_t RecordSize = 0;
+        inline std::atomic<uint64_t> Head{ 0 };
+        inline int64_t FirstFrame = -1;
+    }
+
+    // Returns a callback that counts calls and time per frame, or the callback itself if every slot is taken
+    inline safetyhook::MidHookFn Wrap(const char* name, safetyhook::MidHookFn callback)
+    {
+        if (detail::SlotCount >= MaxSlots) {
+            spdlog::warn("Trace: Out of slots, {} will not be traced.", name);
+            return callback;
+        }
+
+        auto index = detail::SlotCount++;
+        detail::Callbacks[index] = callback;
+        detail::Names[index] = name;
+        return detail::Wrappers[index];
+    }
+
+    // Allocates the ring, call once every hook has been wrapped
+    inline void Start()
+    {
+        detail::RecordSize = TraceFormat::RecordSize((uint32_t)detail::SlotCount);
+        detail::Ring = std::make_unique<uint8_t[]>(Capacity * detail::RecordSize);
+        spdlog::info("Trace: Capturing the last {} frames for {} hook(s) ({} KB).", Capacity, detail::SlotCount, Capacity * detail::RecordSize / 1024);
+    }
+
+    // Call once per frame at the frame boundary with a timestamp in nanoseconds.
+    // Moves the per-hook counters for the frame that just ended into the ring.
+    inline void Frame(int64_t timestamp)
+    {
+        if (!detail::Ring)
+            return;
+        if (detail::FirstFrame < 0)
+            detail::FirstFrame = timestamp;
+
+        auto index = detail::Head.load(std::memory_order_relaxed);
+        auto record = detail::Ring.get() + (index % Capacity) * detail::RecordSize;
+
+        TraceFormat::FrameHeader frame{ (uint64_t)(timestamp - detail::FirstFrame) };
+        memcpy(record, &frame, sizeof(frame));
+        record += sizeof(frame);
+
+        for (size_t i = 0; i < detail::SlotCount; ++i) {
+            TraceFormat::HookSample sample{
+                detail::Slots[i].calls.exchange(0, std::memory_order_relaxed),
+                detail::Slots[i].ticks.exchange(0, std::memory_order_relaxed),
+            };
+            memcpy(record, &sample, sizeof(sample));
+            record += sizeof(sample);
+        }
+
+        detail::Head.store(index + 1, std::memory_order_release);
+    }
+
+    // Writes every frame still in the ring to path. Runs alongside capture, frames overwritten while copying are left out.
+    inline bool Dump(const std::filesystem::path& path, double ticksPerNs)
+    {
+        if (!detail::Ring)
+            return false;
+
+        auto end = detail::Head.load(std::memory_order_acquire);
+        auto begin = end > Capacity ? end - Capacity : 0;
+        if (end == begin) {
+            spdlog::warn("Trace: No frames captured yet.");
+            return true;
+        }
+
+        std::vector<uint8_t> records((size_t)(end - begin) * detail::RecordSize);
+        for (auto index = begin; index < end; ++index)
+            memcpy(records.data() + (index - begin) * detail::RecordSize, detail::Ring.get() + (index % Capacity) * detail::RecordSize, detail::RecordSize);
+
+        // Anything the capture has lapped since we started copying may be torn, drop it
+        auto head = detail::Head.load(std::memory_order_acquire);
+        auto valid = head + 1 > Capacity ? head + 1 - Capacity : 0;
+        auto skip = valid > begin ? (size_t)(valid - begin) : 0;
+        if (skip >= end - begin)
+            return false;
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        TraceFormat::FileHeader header{};
+        memcpy(header.magic, TraceFormat::Magic, sizeof(header.magic));
+        header.version = TraceFormat::Version;
+        header.hookCount = (uint32_t)detail::SlotCount;
+        header.frameCount = (uint32_t)(end - begin - skip);
+        header.ticksPerNs = ticksPerNs;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        for (size_t i = 0; i < detail::SlotCount; ++i) {
+            auto length = (uint16_t)strlen(detail::Names[i]);
+            file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            file.write(detail::Names[i], length);
+        }
+
+        file.write(reinterpret_cast<const char*>(records.data() + skip * detail::RecordSize), (std::streamsize)(header.frameCount * detail::RecordSize));
+        spdlog::info("Trace: Wrote {} frames to {}", header.frameCount, path.string());
+        return file.good();
+    }
+
+    // Dumps the capture to path whenever the hotkey is pressed, and once after dumpAfter has passed if it's non-zero
+    inline void StartDumpThread(std::filesystem::path path, int hotkey, std::chrono::seconds dumpAfter)
+    {
+        std::thread([path, hotkey, dumpAfter] {
+            double ticksPerNs = Profiler::detail::CalibrateTSC();
+            auto start = std::chrono::steady_clock::now();
+            bool dumpedAfter = dumpAfter.count() == 0;
+            bool wasDown = false;
+
+            while (true) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+                bool down = hotkey && (GetAsyncKeyState(hotkey) & 0x8000);
+                if (down && !wasDown && !Dump(path, ticksPerNs))
+                    spdlog::error("Trace: Failed to write {}", path.string());
+                wasDown = down;
+
+                if (!dumpedAfter && std::chrono::steady_clock::now() - start >= dumpAfter) {
+                    dumpedAfter = true;
+                    if (!Dump(path, ticksPerNs))
+                        spdlog::error("Trace: Failed to write {}", path.string());
+                }
+            }
+        }).detach();
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// On-disk layout of a .trace capture, shared by the fix and tools/tracedump. Little endian throughout.
+//   FileHeader
+//   hookCount x { uint16_t length; char name[length]; }
+//   frameCount x { FrameHeader; hookCount x HookSample }
+namespace TraceFormat
+{
+    constexpr char Magic[4] = { 'O', 'P', 'T', 'R' };
+    constexpr uint32_t Version = 1;
+
+    struct FileHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t hookCount;
+        uint32_t frameCount;
+        double ticksPerNs;      // To convert HookSample::ticks to time
+    };
+    static_assert(sizeof(FileHeader) == 24, "Trace file header layout changed");
+
+    struct FrameHeader
+    {
+        uint64_t timestamp;     // Nanoseconds since the first captured frame
+    };
+    static_assert(sizeof(FrameHeader) == 8, "Trace frame header layout changed");
+
+    // What one hook did during one frame
+    struct HookSample
+    {
+        uint32_t calls;
+        uint32_t ticks;         // Total time spent in the callback, in TSC ticks
+    };
+    static_assert(sizeof(HookSample) == 8, "Trace hook sample layout changed");
+
+    constexpr size_t RecordSize(uint32_t hookCount)
+    {
+        return sizeof(FrameHeader) + hookCount * sizeof(HookSample);
+    }
+}
@@ -0,0 +1,109 @@
+// Times how the Fades hook tells capture planes apart from other UI elements: Elements::Classify's fixed-length
+// compare versus strcmp, and checks they agree.
+//   elementbench [--elements N] [--frames N]
+// Elements are laid out like the game's, with names that mostly share the "ktglkids_scl_" prefix, including
+// ones that are a prefix of the capture plane's name or have it as a prefix.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "elements.hpp"
+
+// Keeps a result alive without the compiler seeing through it
+static volatile uint64_t sink;
+
+struct Element
+{
+    alignas(16) char bytes[0x300];
+};
+
+template<typename Classify>
+static double Run(const std::vector<uintptr_t>& order, int frames, Classify&& classify, size_t& planes)
+{
+    planes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        for (auto element : order)
+            planes += classify(element) == Elements::Kind::CapturePlane;
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    sink = planes;
+    return elapsed / ((double)order.size() * frames);
+}
+
+// strcmp one byte at a time, closer to what a CRT without a vectorised strcmp does
+static Elements::Kind ClassifyBytewise(const char* name)
+{
+    const char* plane = "ktglkids_scl_capture_plane_full_rgba8";
+    while (*name && *name == *plane) {
+        ++name;
+        ++plane;
+    }
+    return *name == *plane ? Elements::Kind::CapturePlane : Elements::Kind::Other;
+}
+
+int main(int argc, char** argv)
+{
+    int elementCount = 300;
+    int frames = 20000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--elements") == 0)
+            elementCount = (std::max)(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--frames") == 0)
+            frames = (std::max)(1, atoi(argv[i + 1]));
+    }
+
+    // One in five elements is a capture plane, the rest have names that share its prefix or are short
+    std::mt19937 rng(1234);
+    std::vector<std::unique_ptr<Element>> elements;
+    for (int i = 0; i < elementCount; ++i) {
+        auto element = std::make_unique<Element>();
+        memset(element->bytes, 0xCD, sizeof(element->bytes));
+        std::string name;
+        switch (i % 10) {
+        case 0:
+        case 5: name = "ktglkids_scl_capture_plane_full_rgba8"; break;
+        case 1: name = "ktglkids_scl_capture_plane_half_rgba8"; break;
+        case 3: name = "ktglkids_scl_capture_plane_full_rgba"; break;
+        case 6: name = "ktglkids_scl_capture_plane_full_rgba8_mask"; break;
+        case 8: name = "ui_icon_" + std::to_string(i); break;
+        default: name = "ktglkids_scl_hud_parts_" + std::to_string(i); break;
+        }
+        memcpy(element->bytes + Elements::NameOffset, name.c_str(), name.size() + 1);
+        elements.push_back(std::move(element));
+    }
+
+    // The hook sees the same elements in the same order every frame
+    std::vector<uintptr_t> order;
+    for (const auto& element : elements)
+        order.push_back(reinterpret_cast<uintptr_t>(element->bytes));
+    std::shuffle(order.begin(), order.end(), rng);
+
+    size_t strcmpPlanes = 0, bytewisePlanes = 0, classifyPlanes = 0;
+    auto strcmpNs = Run(order, frames, [](uintptr_t element) {
+        auto name = reinterpret_cast<const char*>(element + Elements::NameOffset);
+        return strcmp(name, "ktglkids_scl_capture_plane_full_rgba8") == 0 ? Elements::Kind::CapturePlane : Elements::Kind::Other;
+    }, strcmpPlanes);
+    auto bytewiseNs = Run(order, frames, [](uintptr_t element) {
+        return ClassifyBytewise(reinterpret_cast<const char*>(element + Elements::NameOffset));
+    }, bytewisePlanes);
+    auto classifyNs = Run(order, frames, [](uintptr_t element) { return Elements::Classify(element); }, classifyPlanes);
+
+    printf("%d elements, %d frames\n", elementCount, frames);
+    printf("%-24s %8.2f ns/call\n", "strcmp (CRT)", strcmpNs);
+    printf("%-24s %8.2f ns/call\n", "strcmp (byte at a time)", bytewiseNs);
+    printf("%-24s %8.2f ns/call\n", "Elements::Classify", classifyNs);
+
+    if (strcmpPlanes != classifyPlanes || bytewisePlanes != classifyPlanes) {
+        printf("Mismatch: strcmp found %zu capture planes, byte-wise %zu, Classify %zu\n", strcmpPlanes, bytewisePlanes, classifyPlanes);
+        return 1;
+    }
+    return 0;
+}
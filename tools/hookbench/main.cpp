@@ -0,0 +1,151 @@
+// Times the stub safetyhook runs for each mid hook, saving every register versus only the ones a callback declares.
+//   hookbench [--calls N]
+// Each stub is called like a function with a trampoline that just returns, so the cycles are the stub's overhead
+// plus an empty callback. Also checks that a register the callback writes comes back out of the stub.
+// x86-64 only, uses the stub code from safetyhook.hpp so it doesn't need the rest of safetyhook or Zydis.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <sys/mman.h>
+#include <x86intrin.h>
+#endif
+
+#include "safetyhook.hpp"
+
+namespace Reg = safetyhook::reg;
+
+static void* AllocateExecutable(size_t size)
+{
+#if defined(_WIN32)
+    return VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return memory == MAP_FAILED ? nullptr : memory;
+#endif
+}
+
+// Callbacks the stubs call, the same kind of work the fix's hooks do
+static void Empty(safetyhook::Context&) {}
+static void SetRax(safetyhook::Context& ctx) { ctx.rax = 42; }
+static void SetXmm0(safetyhook::Context& ctx) { ctx.xmm0.f64[0] = ctx.xmm0.f64[0] * 2.0 + 1.0; }
+
+struct Stub
+{
+    const char* name;
+    safetyhook::RegisterMask registers;
+    safetyhook::MidHookFn callback;
+    uint8_t* code = nullptr;
+    size_t size = 0;
+};
+
+// Lays out a stub the way MidHook::setup does, with a trampoline that returns to the caller
+static bool Build(Stub& stub, uint8_t* trampoline)
+{
+    auto code = safetyhook::detail::mid_hook_stub(stub.registers);
+    stub.size = code.size();
+    stub.code = static_cast<uint8_t*>(AllocateExecutable(code.size()));
+    if (!stub.code)
+        return false;
+
+    std::copy(code.begin(), code.end(), stub.code);
+    safetyhook::store(stub.code + code.size() - 16, stub.callback);
+    safetyhook::store(stub.code + code.size() - 8, trampoline);
+    return true;
+}
+
+// Lowest cycles per call over a few rounds, to stay clear of interrupts and frequency ramp up
+template<typename Fn>
+static double Measure(Fn fn, int calls)
+{
+    double best = 1e30;
+    for (int round = 0; round < 7; ++round) {
+        auto start = __rdtsc();
+        for (int i = 0; i < calls; ++i)
+            fn(i);
+        auto end = __rdtsc();
+        best = (std::min)(best, (double)(end - start) / calls);
+    }
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+#if !SAFETYHOOK_ARCH_X86_64
+    std::cerr << "hookbench only supports x86-64\n";
+    return 2;
+#else
+    int calls = 1000000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--calls") == 0) {
+            calls = (std::max)(1, atoi(argv[i + 1]));
+        }
+        else {
+            std::cerr << "unknown option " << argv[i] << "\n";
+            return 2;
+        }
+    }
+
+    auto trampoline = static_cast<uint8_t*>(AllocateExecutable(1));
+    if (!trampoline) {
+        std::cerr << "Failed to allocate executable memory\n";
+        return 1;
+    }
+    *trampoline = 0xC3; // ret
+
+    std::vector<Stub> stubs = {
+        { "full, empty callback", Reg::all, &Empty },
+        { "lean, empty callback", Reg::none, &Empty },
+        { "full, writes rax", Reg::all, &SetRax },
+        { "lean, writes rax", Reg::rax, &SetRax },
+        { "full, writes xmm0", Reg::all, &SetXmm0 },
+        { "lean, writes xmm0", Reg::xmm0, &SetXmm0 },
+        { "lean, rsi rdi r12-r15", Reg::rsi | Reg::rdi | Reg::r12 | Reg::r13 | Reg::r14 | Reg::r15, &Empty },
+        { "lean, xmm0-15", 0xFFFF0000u, &Empty },
+    };
+
+    // Baseline for the loop and the call itself
+    auto baseline = reinterpret_cast<uint64_t (*)(uint64_t)>(trampoline);
+    double baseCycles = Measure([&](int i) { baseline(i); }, calls);
+
+    int failed = 0;
+    std::printf("%-24s %6s %10s %10s\n", "Stub", "Bytes", "Cycles", "Overhead");
+    for (auto& stub : stubs) {
+        if (!Build(stub, trampoline)) {
+            std::cerr << "Failed to allocate executable memory\n";
+            return 1;
+        }
+
+        // The stub returns through the trampoline, so callers see whatever the callback left in rax / xmm0
+        double cycles = 0;
+        if (stub.callback == &SetXmm0) {
+            auto fn = reinterpret_cast<double (*)(double)>(stub.code);
+            if (fn(2.0) != 5.0) {
+                std::printf("%s: xmm0 written by the callback was lost\n", stub.name);
+                ++failed;
+            }
+            cycles = Measure([&](int i) { fn((double)i); }, calls);
+        }
+        else {
+            auto fn = reinterpret_cast<uint64_t (*)(uint64_t)>(stub.code);
+            if (stub.callback == &SetRax && fn(0) != 42) {
+                std::printf("%s: rax written by the callback was lost\n", stub.name);
+                ++failed;
+            }
+            cycles = Measure([&](int i) { fn(i); }, calls);
+        }
+        std::printf("%-24s %6zu %10.1f %10.1f\n", stub.name, stub.size, cycles, cycles - baseCycles);
+    }
+
+    std::printf("\n%d call(s) per stub, best of 7. %d failed.\n", calls, failed);
+    return failed ? 1 : 0;
+#endif
+}
@@ -0,0 +1,88 @@
+// Stress tests the SeqLock the layout snapshot is published through: one writer republishing resolutions while
+// readers check every snapshot they load is exactly one that was published, never a mix of two.
+//   layouttest [--writes N] [--readers N]
+// Exits with 1 if a reader saw a torn snapshot.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "layout.hpp"
+
+static const float nativeAspect = 16.0f / 9.0f;
+
+// Every snapshot is fully determined by its resolution, so a reader can recompute what it should have seen
+static bool Consistent(const Layout::Snapshot& snapshot)
+{
+    auto expected = Layout::Compute(snapshot.resX, snapshot.resY, nativeAspect);
+    return memcmp(&snapshot, &expected, sizeof(snapshot)) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    int writes = 2000000;
+    int readerCount = 3;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--writes") == 0)
+            writes = (std::max)(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--readers") == 0)
+            readerCount = (std::max)(1, atoi(argv[i + 1]));
+    }
+
+    // Alternating between wider and narrower resolutions changes every field of the snapshot
+    Layout::SeqLock<Layout::Snapshot> lock;
+    lock.Store(Layout::Compute(1920, 1080, nativeAspect));
+
+    std::atomic<bool> bDone = false;
+    std::atomic<int> readersStarted = 0;
+    std::vector<size_t> reads(readerCount), torn(readerCount);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < readerCount; ++r) {
+        readers.emplace_back([&, r] {
+            ++readersStarted;
+            while (!bDone.load(std::memory_order_relaxed)) {
+                auto snapshot = lock.Load();
+                ++reads[r];
+                if (!Consistent(snapshot))
+                    ++torn[r];
+            }
+        });
+    }
+    while (readersStarted < readerCount)
+        std::this_thread::yield();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < writes; ++i) {
+        int resX = i % 2 ? 3440 + i % 1000 : 1280 + i % 1000;
+        int resY = i % 2 ? 1440 : 1024 + i % 500;
+        lock.Store(Layout::Compute(resX, resY, nativeAspect));
+    }
+    bDone = true;
+    for (auto& reader : readers)
+        reader.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t totalReads = 0, totalTorn = 0;
+    for (int r = 0; r < readerCount; ++r) {
+        totalReads += reads[r];
+        totalTorn += torn[r];
+    }
+
+    // Uncontended read cost, what a hook callback pays when the resolution isn't changing
+    constexpr int quietReads = 10000000;
+    auto quietStart = std::chrono::steady_clock::now();
+    float sum = 0;
+    for (int i = 0; i < quietReads; ++i)
+        sum += lock.Load().hudWidth;
+    double quietNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - quietStart).count() / quietReads;
+
+    std::printf("%d writes, %d readers, %zu reads in %.2fs, %zu torn\n", writes, readerCount, totalReads, seconds, totalTorn);
+    std::printf("Uncontended Load(): %.2fns (%g)\n", quietNs, sum > 0 ? 1.0 : 0.0);
+    std::printf("%s\n", totalTorn || totalReads == 0 ? "FAILED" : "No torn snapshots.");
+    return totalTorn || totalReads == 0 ? 1 : 0;
+}
@@ -0,0 +1,224 @@
+// Drives Pacing::Limiter and Pacing::FrameStats with a simulated clock, so pacing can be checked exactly without a real timer.
+//   pacingtest
+// Exits with 1 if any check fails.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "pacing.hpp"
+
+static int failed = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failed; \
+        } \
+    } while (0)
+
+// Time only moves when the limiter sleeps or spins, or when a test says a frame's work took a while
+class SimulatedClock
+{
+public:
+    int64_t now = 0;
+    int64_t oversleep = 0;      // How late every sleep wakes up
+    int64_t relaxStep = 100;    // How long one spin iteration takes
+    int64_t spinMargin = 1000000;
+    int sleeps = 0;
+    int64_t spun = 0;
+
+    int64_t Now() const { return now; }
+
+    void SleepUntil(int64_t deadline)
+    {
+        ++sleeps;
+        if (deadline > now)
+            now = deadline + oversleep;
+    }
+
+    void Relax()
+    {
+        now += relaxStep;
+        spun += relaxStep;
+    }
+
+    int64_t SpinMargin() const { return spinMargin; }
+};
+
+using Limiter = Pacing::Limiter<SimulatedClock>;
+
+// Runs frames that each take work[i % work.size()] before reaching the frame boundary, returning every frametime after the first
+static std::vector<int64_t> Run(Limiter& limiter, const std::vector<int64_t>& work, size_t frames)
+{
+    std::vector<int64_t> frametimes;
+    limiter.Wait();
+    for (size_t i = 0; i < frames; ++i) {
+        limiter.GetClock().now += work[i % work.size()];
+        frametimes.push_back(limiter.Wait());
+    }
+    return frametimes;
+}
+
+static void FirstFrame()
+{
+    Limiter limiter(60);
+    limiter.GetClock().now = 123456;
+    CHECK(limiter.Wait() == 0);
+}
+
+static void Period()
+{
+    CHECK(Limiter(60).Period() == 16666667);
+    CHECK(Limiter(144).Period() == 6944444);
+    CHECK(Limiter(0).Period() == 0);
+    CHECK(Limiter(-5).Period() == 0);
+}
+
+// Frames that finish early are held to the period. Spinning stops on the first tick past the deadline.
+static void SteadyPacing()
+{
+    Limiter limiter(60);
+    auto frametimes = Run(limiter, { 5000000 }, 600);
+    int64_t total = 0;
+    for (auto frametime : frametimes) {
+        CHECK(frametime >= limiter.Period() - 100 && frametime <= limiter.Period() + 100);
+        total += frametime;
+    }
+    // No drift, the deadline advances by exactly one period each frame
+    CHECK(std::llabs(total - 600 * limiter.Period()) <= 100);
+    CHECK(limiter.GetClock().sleeps == 600);
+}
+
+// Waking late from the coarse sleep is absorbed by the spin margin
+static void LateWakeups()
+{
+    Limiter limiter(60);
+    limiter.GetClock().oversleep = 700000;
+    for (auto frametime : Run(limiter, { 3000000 }, 200))
+        CHECK(frametime >= limiter.Period() - 100 && frametime <= limiter.Period() + 100);
+}
+
+// Less than the spin margin left means no sleep at all, only spinning
+static void SpinOnly()
+{
+    Limiter limiter(60);
+    limiter.GetClock().spinMargin = 20000000;
+    auto frametimes = Run(limiter, { 1000000 }, 10);
+    CHECK(limiter.GetClock().sleeps == 0);
+    for (auto frametime : frametimes)
+        CHECK(frametime >= limiter.Period() - 100 && frametime <= limiter.Period() + 100);
+}
+
+// A frame that runs a little long is made up by the next one, so the cadence holds
+static void SmallOverrun()
+{
+    Limiter limiter(60);
+    auto period = limiter.Period();
+    auto frametimes = Run(limiter, { 5000000, 20000000, 5000000, 5000000 }, 4);
+    CHECK(frametimes[1] == 20000000);
+    CHECK(std::llabs(frametimes[0] + frametimes[1] + frametimes[2] - 3 * period) <= 200);
+    CHECK(std::llabs(frametimes[3] - period) <= 100);
+}
+
+// A whole frame or more behind starts the cadence over instead of rushing the next frames
+static void LongStall()
+{
+    Limiter limiter(60);
+    auto period = limiter.Period();
+    auto frametimes = Run(limiter, { 5000000, 50000000, 5000000, 5000000 }, 4);
+    CHECK(frametimes[1] == 50000000);
+    CHECK(std::llabs(frametimes[2] - period) <= 100);
+    CHECK(std::llabs(frametimes[3] - period) <= 100);
+}
+
+// With no target Wait() only measures
+static void Unlimited()
+{
+    Limiter limiter(0);
+    for (auto frametime : Run(limiter, { 4000000, 9000000 }, 6))
+        CHECK(frametime == 4000000 || frametime == 9000000);
+    CHECK(limiter.GetClock().sleeps == 0);
+    CHECK(limiter.GetClock().spun == 0);
+}
+
+// A new target applies from the next deadline on
+static void ChangeTarget()
+{
+    Limiter limiter(60);
+    Run(limiter, { 1000000 }, 5);
+    limiter.SetTarget(30);
+    auto frametimes = Run(limiter, { 1000000 }, 5);
+    for (size_t i = 1; i < frametimes.size(); ++i)
+        CHECK(std::llabs(frametimes[i] - limiter.Period()) <= 100);
+    limiter.SetTarget(0);
+    for (auto frametime : Run(limiter, { 1000000 }, 3))
+        CHECK(frametime == 1000000);
+}
+
+static bool Near(double a, double b, double tolerance = 1e-3) { return std::fabs(a - b) <= tolerance; }
+
+static void Stats()
+{
+    Pacing::FrameStats<1000> stats;
+    CHECK(stats.Compute().frames == 0);
+
+    stats.Record(0);
+    stats.Record(-5);
+    CHECK(stats.Compute().frames == 0);
+
+    for (int i = 0; i < 990; ++i)
+        stats.Record(10000000);
+    for (int i = 0; i < 10; ++i)
+        stats.Record(20000000);
+    auto summary = stats.Compute();
+    CHECK(summary.frames == 1000);
+    CHECK(Near(summary.averageMs, 10.1));
+    CHECK(Near(summary.averageFps, 1000.0 / 10.1));
+    CHECK(Near(summary.low1Fps, 50.0));
+    CHECK(Near(summary.low01Fps, 50.0));
+    CHECK(Near(summary.jitterMs, std::sqrt(0.99 * 0.01 + 0.01 * 9.9 * 9.9), 1e-3));
+
+    // Only the last window of frames counts
+    for (int i = 0; i < 1000; ++i)
+        stats.Record(5000000);
+    summary = stats.Compute();
+    CHECK(Near(summary.averageMs, 5.0));
+    CHECK(Near(summary.low1Fps, 200.0));
+    CHECK(Near(summary.jitterMs, 0.0));
+
+    stats.Reset();
+    CHECK(stats.Compute().frames == 0);
+}
+
+// A limiter feeding stats end to end: paced frames average exactly the target
+static void PacedStats()
+{
+    Limiter limiter(120);
+    Pacing::FrameStats<256> stats;
+    for (auto frametime : Run(limiter, { 2000000, 6000000 }, 256))
+        stats.Record(frametime);
+    auto summary = stats.Compute();
+    CHECK(Near(summary.averageFps, 120.0, 0.01));
+    CHECK(summary.jitterMs < 0.001);
+}
+
+int main()
+{
+    FirstFrame();
+    Period();
+    SteadyPacing();
+    LateWakeups();
+    SpinOnly();
+    SmallOverrun();
+    LongStall();
+    Unlimited();
+    ChangeTarget();
+    Stats();
+    PacedStats();
+
+    std::printf("%s\n", failed ? "FAILED" : "All pacing checks passed.");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,423 @@
+// Checks Pe::Image against hand-built images: truncated headers, missing, empty and overlapping sections,
+// RVAs that don't map to anything and broken exception directories.
+//   petest
+// Exits with 1 if any check fails.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "pe.hpp"
+
+static int failed = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failed; \
+        } \
+    } while (0)
+
+// Describes an image to build. Section contents are filled with the section's index + 1 so reads can be told apart.
+struct Builder
+{
+    struct SectionSpec
+    {
+        std::string name;
+        uint32_t rva;
+        uint32_t virtualSize;
+        uint32_t rawOffset;
+        uint32_t rawSize;
+        uint32_t characteristics;
+    };
+
+    static constexpr uint32_t lfanew = 0x80;
+    static constexpr uint32_t sizeOfHeaders = 0x400;
+    static constexpr uint32_t code = Pe::ScnCntCode | Pe::ScnMemExecute | 0x40000000;
+    static constexpr uint32_t rdata = Pe::ScnCntInitializedData | 0x40000000;
+    static constexpr uint32_t data = Pe::ScnCntInitializedData | 0x40000000 | Pe::ScnMemWrite;
+
+    bool bPe32Plus = true;
+    uint32_t directoryCount = 16;
+    uint32_t exceptionRva = 0;
+    uint32_t exceptionSize = 0;
+    uint32_t sizeOfImage = 0x5000;
+    std::vector<SectionSpec> sections;
+
+    size_t OptionalHeaderSize() const { return (bPe32Plus ? 112 : 96) + directoryCount * 8; }
+    size_t HeadersEnd() const { return lfanew + 4 + sizeof(Pe::FileHeader) + OptionalHeaderSize() + sections.size() * sizeof(Pe::SectionHeader); }
+
+    // The image as it would be on disk
+    std::vector<std::uint8_t> File() const
+    {
+        size_t size = sizeOfHeaders;
+        for (const auto& section : sections)
+            size = (std::max)(size, (size_t)section.rawOffset + section.rawSize);
+
+        std::vector<std::uint8_t> file(size);
+        Put(file, 0, (uint16_t)0x5A4D);
+        Put(file, 0x3C, (int32_t)lfanew);
+        Put(file, lfanew, (uint32_t)0x00004550);
+
+        Pe::FileHeader header{};
+        header.machine = bPe32Plus ? 0x8664 : 0x14C;
+        header.numberOfSections = (uint16_t)sections.size();
+        header.timeDateStamp = 0x5F5E1000;
+        header.sizeOfOptionalHeader = (uint16_t)OptionalHeaderSize();
+        Put(file, lfanew + 4, header);
+
+        size_t optional = lfanew + 4 + sizeof(Pe::FileHeader);
+        size_t directories = optional + (bPe32Plus ? 112 : 96);
+        Put(file, optional, (uint16_t)(bPe32Plus ? 0x20B : 0x10B));
+        Put(file, optional + 56, sizeOfImage);
+        Put(file, optional + 60, sizeOfHeaders);
+        Put(file, directories - 4, directoryCount);
+        if (directoryCount > 3) {
+            Put(file, directories + 3 * 8, exceptionRva);
+            Put(file, directories + 3 * 8 + 4, exceptionSize);
+        }
+
+        size_t table = optional + OptionalHeaderSize();
+        for (size_t i = 0; i < sections.size(); ++i) {
+            const auto& spec = sections[i];
+            Pe::SectionHeader section{};
+            memcpy(section.name, spec.name.data(), (std::min)(spec.name.size(), sizeof(section.name)));
+            section.virtualSize = spec.virtualSize;
+            section.virtualAddress = spec.rva;
+            section.sizeOfRawData = spec.rawSize;
+            section.pointerToRawData = spec.rawOffset;
+            section.characteristics = spec.characteristics;
+            Put(file, table + i * sizeof(Pe::SectionHeader), section);
+            std::fill_n(file.begin() + spec.rawOffset, spec.rawSize, (std::uint8_t)(i + 1));
+        }
+        return file;
+    }
+
+    // The image as the loader would map it
+    std::vector<std::uint8_t> Mapped() const
+    {
+        auto file = File();
+        std::vector<std::uint8_t> mapped(sizeOfImage);
+        std::copy_n(file.begin(), (std::min)((size_t)sizeOfHeaders, file.size()), mapped.begin());
+        for (const auto& section : sections) {
+            size_t size = (std::min)(section.rawSize, section.virtualSize ? section.virtualSize : section.rawSize);
+            if (section.rva < mapped.size())
+                std::copy_n(file.begin() + section.rawOffset, (std::min)(size, mapped.size() - section.rva), mapped.begin() + section.rva);
+        }
+        return mapped;
+    }
+
+    template<typename T>
+    static void Put(std::vector<std::uint8_t>& file, size_t offset, const T& value)
+    {
+        memcpy(file.data() + offset, &value, sizeof(T));
+    }
+};
+
+// .text, .rdata, .pdata and .data the usual way around, with a three entry exception directory
+static Builder Typical()
+{
+    Builder builder;
+    builder.sections = {
+        { ".text", 0x1000, 0x1800, 0x400, 0x1800, Builder::code },
+        { ".rdata", 0x3000, 0x200, 0x1C00, 0x200, Builder::rdata },
+        { ".pdata", 0x4000, 0x24, 0x1E00, 0x200, Builder::rdata },
+        { ".data", 0x4800, 0x800, 0x2000, 0x200, Builder::data },
+    };
+    builder.exceptionRva = 0x4000;
+    builder.exceptionSize = 3 * sizeof(Pe::Function);
+    return builder;
+}
+
+static std::vector<std::uint8_t> WithFunctions(const Builder& builder, std::vector<std::uint8_t> file, const std::vector<Pe::Function>& functions)
+{
+    Pe::Image image(file.data(), file.size(), Pe::Layout::File);
+    if (auto table = image.At(builder.exceptionRva))
+        memcpy(table, functions.data(), functions.size() * sizeof(Pe::Function));
+    return file;
+}
+
+static void Valid()
+{
+    auto builder = Typical();
+    auto file = WithFunctions(builder, builder.File(), { { 0x1200, 0x1300, 0x3000 }, { 0x1000, 0x1100, 0x3010 }, { 0x1100, 0x1200, 0x3020 } });
+
+    Pe::Image image(file.data(), file.size(), Pe::Layout::File);
+    CHECK(image.Valid());
+    CHECK(image.Machine() == 0x8664);
+    CHECK(image.Timestamp() == 0x5F5E1000);
+    CHECK(image.SizeOfImage() == 0x5000);
+    CHECK(image.Sections().size() == 4);
+    CHECK(image.Sections()[0].name == ".text" && image.Sections()[0].Executable() && !image.Sections()[0].Writable());
+    CHECK(image.Sections()[1].InitializedData() && !image.Sections()[1].Writable());
+    CHECK(image.Sections()[3].Writable());
+
+    auto code = image.Ranges(Scanner::Section::Code);
+    CHECK(code.size() == 1 && code[0].data == file.data() + 0x400 && code[0].size == 0x1800 && code[0].rva == 0x1000);
+    // Headers plus every section, in file order
+    auto any = image.Ranges(Scanner::Section::Any);
+    CHECK(any.size() == 5 && any[0].data == file.data() && any[0].size == Builder::sizeOfHeaders);
+    for (size_t i = 1; i < any.size(); ++i)
+        CHECK(any[i - 1].data < any[i].data);
+    // .data's virtual size is larger than its raw data, only the raw data exists on disk
+    CHECK(any.back().rva == 0x4800 && any.back().size == 0x200);
+    CHECK(image.Ranges(Scanner::Section::Data).size() == any.size());
+
+    CHECK(image.At(0) == file.data());
+    CHECK(image.At(0x1000) == file.data() + 0x400 && *image.At(0x1000) == 1);
+    CHECK(image.At(0x3010) == file.data() + 0x1C10 && *image.At(0x3010) == 2);
+    CHECK(image.At(0x49FF) == file.data() + 0x21FF);
+    // Zero fill past .data's raw data only exists once loaded
+    CHECK(image.At(0x4A00) == nullptr);
+    CHECK(image.RvaOf(file.data() + 0x1C10) == 0x3010);
+    CHECK(image.RvaOf(file.data() + 0x10) == 0x10);
+    CHECK(image.SectionAt(0x4F00) == &image.Sections()[3]);
+    CHECK(image.SectionAt(0x2800) == nullptr);
+
+    auto functions = image.Functions();
+    CHECK(functions.size() == 3);
+    CHECK(functions.size() == 3 && functions[0].begin == 0x1000 && functions[1].begin == 0x1100 && functions[2].begin == 0x1200);
+
+    // Same image as loaded
+    auto memory = builder.Mapped();
+    std::copy_n(file.begin() + 0x1E00, 3 * sizeof(Pe::Function), memory.begin() + 0x4000);
+    Pe::Image loaded(memory.data(), memory.size(), Pe::Layout::Mapped);
+    CHECK(loaded.Valid());
+    code = loaded.Ranges(Scanner::Section::Code);
+    CHECK(code.size() == 1 && code[0].data == memory.data() + 0x1000 && code[0].size == 0x1800);
+    any = loaded.Ranges(Scanner::Section::Any);
+    CHECK(any.size() == 1 && any[0].data == memory.data() && any[0].size == memory.size());
+    CHECK(loaded.At(0x4A00) == memory.data() + 0x4A00);
+    CHECK(loaded.RvaOf(memory.data() + 0x3010) == 0x3010);
+    CHECK(loaded.Functions().size() == 3);
+
+    // 0 trusts SizeOfImage
+    Pe::Image module(memory.data(), 0, Pe::Layout::Mapped);
+    CHECK(module.Valid() && module.Ranges(Scanner::Section::Any)[0].size == 0x5000);
+}
+
+// Every truncation of the headers is rejected without reading past the end
+static void TruncatedHeaders()
+{
+    auto builder = Typical();
+    auto file = builder.File();
+    size_t headersEnd = builder.HeadersEnd();
+
+    for (size_t size = 0; size < headersEnd; ++size) {
+        // Copied so reading past size lands outside the allocation, where a sanitizer or a page fault catches it
+        std::vector<std::uint8_t> truncated(file.begin(), file.begin() + size);
+        Pe::Image image(truncated.data(), truncated.size(), Pe::Layout::File);
+        CHECK(!image.Valid());
+        CHECK(image.Ranges(Scanner::Section::Any).empty());
+        CHECK(image.At(0) == nullptr);
+        CHECK(image.Functions().empty());
+        if (image.Valid())
+            std::printf("  accepted at %zu bytes\n", size);
+    }
+
+    std::vector<std::uint8_t> headers(file.begin(), file.begin() + headersEnd);
+    Pe::Image image(headers.data(), headers.size(), Pe::Layout::File);
+    CHECK(image.Valid());
+    // The sections are all past the end, there's nothing to scan but the headers
+    CHECK(image.Ranges(Scanner::Section::Code).empty());
+    CHECK(image.At(0x1000) == nullptr);
+    CHECK(image.Functions().empty());
+
+    CHECK(std::string(Pe::Image(file.data(), 0x40, Pe::Layout::File).Error()) == "no PE header");
+    CHECK(std::string(Pe::Image(file.data(), headersEnd - 1, Pe::Layout::File).Error()) == "truncated section table");
+    CHECK(!Pe::Image(nullptr, 0, Pe::Layout::Mapped).Valid());
+}
+
+static void BadSignatures()
+{
+    auto file = Typical().File();
+
+    auto broken = file;
+    broken[0] = 'X';
+    CHECK(std::string(Pe::Image(broken.data(), broken.size(), Pe::Layout::File).Error()) == "not an executable (no MZ header)");
+
+    broken = file;
+    broken[Builder::lfanew] = 'X';
+    CHECK(std::string(Pe::Image(broken.data(), broken.size(), Pe::Layout::File).Error()) == "no PE header");
+
+    for (int32_t lfanew : { 0, -4, (int32_t)file.size() - 2, (int32_t)file.size(), 0x7FFFFFFF }) {
+        broken = file;
+        Builder::Put(broken, 0x3C, lfanew);
+        CHECK(!Pe::Image(broken.data(), broken.size(), Pe::Layout::File).Valid());
+    }
+}
+
+static void NoSections()
+{
+    Builder builder;
+    auto file = builder.File();
+    Pe::Image image(file.data(), file.size(), Pe::Layout::File);
+    CHECK(image.Valid());
+    CHECK(image.Sections().empty());
+    CHECK(image.Ranges(Scanner::Section::Code).empty());
+    CHECK(image.Ranges(Scanner::Section::Any).size() == 1);
+    CHECK(image.At(0x3FF) == file.data() + 0x3FF);
+    CHECK(image.At(0x400) == nullptr);
+    CHECK(image.SectionAt(0x1000) == nullptr);
+    CHECK(image.Functions().empty());
+}
+
+// Sections with nothing in them are left out of the ranges
+static void EmptySections()
+{
+    Builder builder;
+    builder.sections = {
+        { ".text", 0x1000, 0x1000, 0x400, 0x1000, Builder::code },
+        { ".tls", 0x2000, 0, 0x1400, 0, Builder::data },              // Nothing at all
+        { ".bss", 0x3000, 0x1000, 0, 0, Builder::data },              // Zero fill only
+        { ".empty", 0x4000, 0, 0x1400, 0x200, Builder::code },        // No virtual size, raw size is used
+    };
+    auto file = builder.File();
+    Pe::Image image(file.data(), file.size(), Pe::Layout::File);
+    CHECK(image.Valid());
+
+    auto code = image.Ranges(Scanner::Section::Code);
+    CHECK(code.size() == 2 && code[0].rva == 0x1000 && code[1].rva == 0x4000 && code[1].size == 0x200);
+    auto any = image.Ranges(Scanner::Section::Any);
+    CHECK(any.size() == 3);
+    for (const auto& range : any)
+        CHECK(range.size != 0 && range.data + range.size <= file.data() + file.size());
+
+    CHECK(image.At(0x2000) == nullptr);
+    CHECK(image.At(0x3000) == nullptr);
+    CHECK(image.SectionAt(0x3FFF) == &image.Sections()[2]);
+    CHECK(image.SectionAt(0x2000) == nullptr);
+
+    auto memory = builder.Mapped();
+    Pe::Image loaded(memory.data(), memory.size(), Pe::Layout::Mapped);
+    CHECK(loaded.Ranges(Scanner::Section::Code).size() == 2);
+    CHECK(loaded.At(0x3000) == memory.data() + 0x3000);
+}
+
+// Overlapping sections and raw data running past the end of the file
+static void OverlappingSections()
+{
+    Builder builder;
+    builder.sections = {
+        { ".text", 0x1000, 0x2000, 0x400, 0x2000, Builder::code },
+        { ".text2", 0x1800, 0x1000, 0x1400, 0x1000, Builder::code },  // Overlaps .text both in memory and on disk
+        { ".late", 0x4000, 0x800, 0x2400, 0x800, Builder::rdata },
+    };
+    auto file = builder.File();
+    file.resize(0x2600);
+
+    Pe::Image image(file.data(), file.size(), Pe::Layout::File);
+    CHECK(image.Valid());
+    auto code = image.Ranges(Scanner::Section::Code);
+    CHECK(code.size() == 2);
+    CHECK(code.size() == 2 && code[0].data <= code[1].data);
+    for (const auto& range : image.Ranges(Scanner::Section::Any))
+        CHECK(range.data >= file.data() && range.data + range.size <= file.data() + file.size());
+    // .late's raw data is cut short by the end of the file
+    auto any = image.Ranges(Scanner::Section::Any);
+    CHECK(any.back().rva == 0x4000 && any.back().size == 0x200);
+
+    // The first section listed wins
+    CHECK(image.At(0x1800) == file.data() + 0xC00);
+    CHECK(image.SectionAt(0x1800) == &image.Sections()[0]);
+    CHECK(image.RvaOf(file.data() + 0x1400) == 0x2000);
+    CHECK(image.At(0x41FF) == file.data() + 0x25FF);
+    CHECK(image.At(0x4200) == nullptr);
+    CHECK(image.RvaOf(file.data() + 0x2600) == Pe::npos);
+
+    // A raw offset past the end of the file leaves nothing to scan
+    builder.sections[2].rawOffset = 0x8000;
+    file = builder.File();
+    file.resize(0x2600);
+    Pe::Image pastEnd(file.data(), file.size(), Pe::Layout::File);
+    CHECK(pastEnd.Valid());
+    CHECK(pastEnd.Ranges(Scanner::Section::Any).size() == 3);
+    CHECK(pastEnd.At(0x4000) == nullptr);
+}
+
+static void RvasOutOfRange()
+{
+    auto builder = Typical();
+    auto file = builder.File();
+    Pe::Image image(file.data(), file.size(), Pe::Layout::File);
+    for (uint32_t rva : { 0x2C00u, 0x5000u, 0x10000u, 0x7FFFFFFFu, 0xFFFFFFFFu, Pe::npos - 1 })
+        CHECK(image.At(rva) == nullptr);
+    CHECK(image.SectionAt(0xFFFFFFFF) == nullptr);
+    CHECK(image.RvaOf(file.data() - 1) == Pe::npos);
+    CHECK(image.RvaOf(file.data() + file.size()) == Pe::npos);
+
+    auto memory = builder.Mapped();
+    Pe::Image loaded(memory.data(), memory.size(), Pe::Layout::Mapped);
+    CHECK(loaded.At(0x4FFF) == memory.data() + 0x4FFF);
+    for (uint32_t rva : { 0x5000u, 0xFFFFFFFFu })
+        CHECK(loaded.At(rva) == nullptr);
+    CHECK(loaded.RvaOf(memory.data() + memory.size()) == Pe::npos);
+
+    // An exception directory pointing outside the image
+    builder.exceptionRva = 0xFFFFFFF0;
+    file = builder.File();
+    CHECK(Pe::Image(file.data(), file.size(), Pe::Layout::File).Functions().empty());
+    builder.exceptionRva = 0x4000;
+    builder.exceptionSize = 0xFFFFFFF0;
+    file = builder.File();
+    CHECK(Pe::Image(file.data(), file.size(), Pe::Layout::File).Functions().empty());
+}
+
+static void ExceptionDirectory()
+{
+    // Empty .pdata
+    auto builder = Typical();
+    builder.exceptionSize = 0;
+    auto file = builder.File();
+    CHECK(Pe::Image(file.data(), file.size(), Pe::Layout::File).Functions().empty());
+
+    // Smaller than one entry
+    builder.exceptionSize = sizeof(Pe::Function) - 1;
+    file = builder.File();
+    CHECK(Pe::Image(file.data(), file.size(), Pe::Layout::File).Functions().empty());
+
+    // A partial trailing entry is dropped
+    builder.exceptionSize = sizeof(Pe::Function) + 4;
+    file = WithFunctions(builder, builder.File(), { { 0x1000, 0x1010, 0x3000 } });
+    auto functions = Pe::Image(file.data(), file.size(), Pe::Layout::File).Functions();
+    CHECK(functions.size() == 1 && functions[0].begin == 0x1000 && functions[0].end == 0x1010);
+
+    // Only part of the table is backed by raw data
+    builder.sections[2].rawSize = 0x10;
+    builder.exceptionSize = 3 * sizeof(Pe::Function);
+    file = builder.File();
+    CHECK(Pe::Image(file.data(), file.size(), Pe::Layout::File).Functions().empty());
+
+    // Too few data directories to have one
+    builder = Typical();
+    builder.directoryCount = 3;
+    file = builder.File();
+    Pe::Image image(file.data(), file.size(), Pe::Layout::File);
+    CHECK(image.Valid() && image.Functions().empty());
+
+    // PE32 keeps its directories 16 bytes earlier
+    builder = Typical();
+    builder.bPe32Plus = false;
+    file = WithFunctions(builder, builder.File(), { { 0x1000, 0x1010, 0x3000 }, { 0x1020, 0x1030, 0x3000 }, { 0x1040, 0x1050, 0x3000 } });
+    Pe::Image pe32(file.data(), file.size(), Pe::Layout::File);
+    CHECK(pe32.Valid() && pe32.Machine() == 0x14C && pe32.Sections().size() == 4);
+    CHECK(pe32.Functions().size() == 3);
+}
+
+int main()
+{
+    Valid();
+    TruncatedHeaders();
+    BadSignatures();
+    NoSections();
+    EmptySections();
+    OverlappingSections();
+    RvasOutOfRange();
+    ExceptionDirectory();
+
+    std::printf("%s\n", failed ? "FAILED" : "All PE checks passed.");
+    return failed ? 1 : 0;
+}
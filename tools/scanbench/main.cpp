@@ -0,0 +1,230 @@
+// Times resolving every signature the fix uses: one scan per signature, the way it used to be done, versus the
+// single batched pass it does now. The fix counts matches up to one more than expected so it can warn about
+// ambiguous signatures, which the per-signature scans are also timed doing.
+// Then times the batched scan the fix does at startup on each of --workers (default 1,2,4,8) worker threads.
+//   scanbench [OPPW4.exe] [--size MB] [--runs N] [--workers N,N,...]
+// Without an exe, scans a synthetic image of --size MB (default 64) with bytes drawn at x64 code frequencies and
+// every signature planted once. Reports the median of --runs (default 5) and checks every way resolves the same.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mappedfile.hpp"
+#include "signatures.hpp"
+
+using Ranges = std::vector<Pe::Range>;
+
+// What to scan for each kind of signature
+struct Target
+{
+    Ranges code;
+    Ranges any;
+
+    const Ranges& For(Scanner::Section section) const { return section == Scanner::Section::Code ? code : any; }
+};
+
+// Bytes drawn with the scanner's own x64 byte frequencies, so prefilter and anchor hits are about as common as in real code
+static std::vector<std::uint8_t> MakeImage(size_t size, const std::vector<Memory::Signature*>& signatures, std::mt19937& rng)
+{
+    std::vector<std::uint8_t> weighted;
+    for (int byte = 0; byte < 256; ++byte)
+        weighted.insert(weighted.end(), Scanner::detail::ByteFrequency[byte], (std::uint8_t)byte);
+
+    std::vector<std::uint8_t> image(size);
+    for (auto& byte : image)
+        byte = weighted[rng() % weighted.size()];
+
+    for (auto signature : signatures) {
+        const auto& pattern = signature->pattern;
+        size_t offset = rng() % (size - pattern.size());
+        for (size_t i = 0; i < pattern.size(); ++i)
+            image[offset + i] = pattern.mask[i] ? pattern.bytes[i] : (std::uint8_t)rng();
+    }
+    return image;
+}
+
+// Median time of runs calls to scan, in milliseconds
+static double Time(int runs, const std::function<void()>& scan)
+{
+    std::vector<double> times;
+    for (int run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        scan();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// How many matches the fix looks for, see Memory::PatternScan
+static size_t Limit(const Memory::Signature& signature)
+{
+    return (std::max)(signature.expected, signature.index + 1) + 1;
+}
+
+// Up to limit matches of each signature in address order, one walk over the image per signature
+static std::vector<std::vector<const std::uint8_t*>> ScanSeparately(const Target& target, const std::vector<Memory::Signature*>& signatures,
+    Scanner::Kernel kernel, bool bCount)
+{
+    std::vector<std::vector<const std::uint8_t*>> found;
+    for (auto signature : signatures) {
+        std::vector<const std::uint8_t*> matches;
+        size_t limit = bCount ? Limit(*signature) : 1;
+        for (const auto& range : target.For(signature->section)) {
+            for (size_t offset = 0; offset < range.size && matches.size() < limit;) {
+                auto match = Scanner::Find(range.data + offset, range.size - offset, signature->pattern, kernel);
+                if (match == Scanner::npos)
+                    break;
+                matches.push_back(range.data + offset + match);
+                offset += match + 1;
+            }
+        }
+        found.push_back(std::move(matches));
+    }
+    return found;
+}
+
+// Up to limit matches of each signature in address order, one pass per kind of section for all of them
+static std::vector<std::vector<const std::uint8_t*>> ScanBatched(const Target& target, const std::vector<Memory::Signature*>& signatures,
+    unsigned int workers, bool bCount)
+{
+    std::vector<std::vector<const std::uint8_t*>> found(signatures.size());
+    for (auto section : { Scanner::Section::Any, Scanner::Section::Code }) {
+        std::vector<size_t> indices;
+        std::vector<Scanner::PatternView> patterns;
+        for (size_t i = 0; i < signatures.size(); ++i) {
+            if ((signatures[i]->section == Scanner::Section::Code) == (section == Scanner::Section::Code)) {
+                indices.push_back(i);
+                patterns.push_back(signatures[i]->pattern);
+            }
+        }
+        if (patterns.empty())
+            continue;
+
+        Scanner::BatchScanner scanner(std::move(patterns));
+        for (const auto& range : target.For(section)) {
+            std::vector<size_t> remaining(indices.size());
+            for (size_t i = 0; i < indices.size(); ++i)
+                remaining[i] = (bCount ? Limit(*signatures[indices[i]]) : 1) - found[indices[i]].size();
+
+            auto offsets = Scanner::ParallelScanAll(scanner, range.data, range.size, remaining, workers);
+            for (size_t i = 0; i < indices.size(); ++i) {
+                for (auto offset : offsets[i])
+                    found[indices[i]].push_back(range.data + offset);
+            }
+        }
+    }
+    return found;
+}
+
+int main(int argc, char** argv)
+{
+    const char* exePath = nullptr;
+    size_t sizeMb = 64;
+    int runs = 5;
+    std::vector<unsigned int> workerCounts = { 1, 2, 4, 8 };
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            sizeMb = (size_t)(std::max)(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = (std::max)(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workerCounts.clear();
+            for (char* next = argv[++i]; *next;) {
+                workerCounts.push_back((unsigned int)(std::max)(1L, strtol(next, &next, 10)));
+                if (*next == ',')
+                    ++next;
+                else if (*next)
+                    break;
+            }
+        }
+        else if (argv[i][0] != '-' && !exePath) {
+            exePath = argv[i];
+        }
+        else {
+            std::cerr << "usage: scanbench [OPPW4.exe] [--size MB] [--runs N] [--workers N,N,...]\n";
+            return 2;
+        }
+    }
+
+    auto signatures = Signatures;
+    signatures.insert(signatures.end(), DeferredSignatures.begin(), DeferredSignatures.end());
+
+    std::mt19937 rng(0x5CA4);
+    std::vector<std::uint8_t> synthetic;
+    std::unique_ptr<MappedFile> file;
+    Target target;
+    if (exePath) {
+        file = std::make_unique<MappedFile>(exePath);
+        if (!*file) {
+            std::cerr << "Failed to open " << exePath << "\n";
+            return 1;
+        }
+        Pe::Image image(file->Data(), file->Size(), Pe::Layout::File);
+        if (!image.Valid()) {
+            std::cerr << exePath << ": " << image.Error() << "\n";
+            return 1;
+        }
+        target = { image.Ranges(Scanner::Section::Code), image.Ranges(Scanner::Section::Any) };
+        std::printf("%s: %zu MB\n", exePath, file->Size() / (1024 * 1024));
+    }
+    else {
+        synthetic = MakeImage(sizeMb * 1024 * 1024, signatures, rng);
+        target.code = target.any = { { synthetic.data(), synthetic.size(), 0 } };
+        std::printf("Synthetic image: %zu MB\n", sizeMb);
+    }
+    std::printf("%zu signatures, %s scan kernel, %u hardware threads, median of %d runs\n\n", signatures.size(),
+        Scanner::KernelName(Scanner::DetectKernel()), std::thread::hardware_concurrency(), runs);
+
+    auto kernel = std::string("(") + Scanner::KernelName(Scanner::DetectKernel()) + ")";
+    int failed = 0;
+    for (bool bCount : { false, true }) {
+        std::vector<std::vector<const std::uint8_t*>> separate, batched;
+        auto scalarMs = Time(runs, [&] { separate = ScanSeparately(target, signatures, Scanner::Kernel::Scalar, bCount); });
+        auto kernelMs = Time(runs, [&] { separate = ScanSeparately(target, signatures, Scanner::DetectKernel(), bCount); });
+        auto batchMs = Time(runs, [&] { batched = ScanBatched(target, signatures, 1, bCount); });
+
+        std::printf("%s\n", bCount ? "Counting matches, as the fix does:" : "First match only:");
+        std::printf("  %-36s %10.2fms\n", "One scan per signature (Scalar)", scalarMs);
+        std::printf("  %-36s %10.2fms\n", ("One scan per signature " + kernel).c_str(), kernelMs);
+        std::printf("  %-36s %10.2fms\n", "Batched, 1 worker", batchMs);
+
+        for (size_t i = 0; i < signatures.size(); ++i) {
+            if (separate[i] != batched[i]) {
+                std::printf("%s: batched scan found different matches\n", signatures[i]->name);
+                ++failed;
+            }
+        }
+    }
+
+    // Same scan as the fix's startup, which uses Scanner::DefaultWorkers()
+    std::vector<std::vector<const std::uint8_t*>> serial;
+    std::printf("Batched, counting matches, by worker count (the fix uses %u here):\n", Scanner::DefaultWorkers());
+    double oneWorkerMs = 0;
+    for (auto workers : workerCounts) {
+        std::vector<std::vector<const std::uint8_t*>> found;
+        auto ms = Time(runs, [&] { found = ScanBatched(target, signatures, workers, true); });
+        if (serial.empty()) {
+            serial = found;
+            oneWorkerMs = ms;
+        }
+        std::printf("  %2u worker(s) %10.2fms %6.2fx\n", workers, ms, oneWorkerMs / ms);
+
+        if (found != serial) {
+            std::printf("%u workers found different matches than %u\n", workers, workerCounts.front());
+            ++failed;
+        }
+    }
+    return failed ? 1 : 0;
+}
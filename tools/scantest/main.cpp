@@ -0,0 +1,264 @@
+// Checks the scanner against a brute force search: every Find kernel, BatchScanner and the parallel scans
+// with every worker count, including matches that straddle the blocks the parallel scans split the data into.
+//   scantest
+// Exits with 1 if any check fails.
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "scanner.hpp"
+
+static int failed = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failed; \
+        } \
+    } while (0)
+
+static bool MatchesAt(const std::vector<std::uint8_t>& data, size_t offset, const Scanner::Pattern& pattern)
+{
+    if (offset + pattern.size() > data.size())
+        return false;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        if ((data[offset + i] & pattern.mask[i]) != pattern.bytes[i])
+            return false;
+    }
+    return true;
+}
+
+// Every match in address order, up to limit
+static std::vector<size_t> BruteForce(const std::vector<std::uint8_t>& data, const Scanner::Pattern& pattern, size_t limit = Scanner::npos)
+{
+    std::vector<size_t> matches;
+    for (size_t offset = 0; offset + pattern.size() <= data.size() && matches.size() < limit; ++offset) {
+        if (MatchesAt(data, offset, pattern))
+            matches.push_back(offset);
+    }
+    return matches;
+}
+
+static size_t First(const std::vector<size_t>& matches) { return matches.empty() ? Scanner::npos : matches.front(); }
+
+// Mostly random bytes, with stretches drawn from a few common opcode bytes so partial matches are frequent
+static std::vector<std::uint8_t> MakeData(size_t size, std::mt19937& rng)
+{
+    constexpr std::uint8_t common[] = { 0x48, 0x89, 0x8B, 0x0F, 0x00, 0xCC };
+    std::vector<std::uint8_t> data(size);
+    bool bCommon = false;
+    for (size_t i = 0; i < size; ++i) {
+        if (i % 4096 == 0)
+            bCommon = rng() % 2 == 0;
+        data[i] = bCommon ? common[rng() % std::size(common)] : static_cast<std::uint8_t>(rng());
+    }
+    return data;
+}
+
+// Takes the bytes at offset as a pattern, wildcarding some of them
+static Scanner::Pattern PatternAt(const std::vector<std::uint8_t>& data, size_t offset, size_t length, std::mt19937& rng, bool bWildcards = true)
+{
+    Scanner::Pattern pattern;
+    for (size_t i = 0; i < length; ++i) {
+        bool bWildcard = bWildcards && i != 0 && rng() % 5 == 0;
+        pattern.bytes.push_back(bWildcard ? 0x00 : data[offset + i]);
+        pattern.mask.push_back(bWildcard ? 0x00 : 0xFF);
+    }
+    return pattern;
+}
+
+static void Parsing()
+{
+    auto pattern = Scanner::Parse("48 8B ?? 0f ? C3");
+    CHECK(pattern.size() == 6);
+    CHECK(pattern.bytes[0] == 0x48 && pattern.bytes[1] == 0x8B && pattern.bytes[3] == 0x0F && pattern.bytes[5] == 0xC3);
+    CHECK(pattern.mask[2] == 0x00 && pattern.mask[4] == 0x00 && pattern.mask[5] == 0xFF);
+
+    // Compiled signatures parse the same and pick the same anchors
+    constexpr auto& compiled = Scanner::Sig<"48 8B ?? 0f ? C3">;
+    auto view = pattern.View();
+    CHECK(compiled.size() == view.size());
+    for (size_t i = 0; i < view.size(); ++i)
+        CHECK(compiled.bytes[i] == view.bytes[i] && compiled.mask[i] == view.mask[i]);
+    CHECK(compiled.anchors.rare == view.anchors.rare && compiled.anchors.rare2 == view.anchors.rare2);
+
+    std::vector<std::uint8_t> data = { 0x90, 0x48, 0x8B, 0x05, 0x0F, 0x11, 0xC3, 0x90 };
+    CHECK(Scanner::Matches(data.data() + 1, compiled));
+    CHECK(!Scanner::Matches(data.data(), compiled));
+}
+
+static void Kernels(std::mt19937& rng)
+{
+    std::vector<Scanner::Kernel> kernels = { Scanner::Kernel::Scalar };
+#if SCANNER_X86
+    kernels.push_back(Scanner::Kernel::SSE2);
+    if (Scanner::DetectKernel() == Scanner::Kernel::AVX2)
+        kernels.push_back(Scanner::Kernel::AVX2);
+#endif
+
+    for (int round = 0; round < 200; ++round) {
+        auto data = MakeData(1 + rng() % 3000, rng);
+        size_t length = 1 + rng() % 40;
+        if (length > data.size())
+            length = data.size();
+        // Mostly patterns that are in the data, often right at the end where the SIMD loops hand over to the scalar tail
+        size_t offset = round % 3 == 0 ? data.size() - length : rng() % (data.size() - length + 1);
+        auto pattern = round % 7 == 0 ? PatternAt(MakeData(length, rng), 0, length, rng) : PatternAt(data, offset, length, rng);
+        auto expected = First(BruteForce(data, pattern));
+
+        for (auto kernel : kernels) {
+            auto found = Scanner::Find(data.data(), data.size(), pattern, kernel);
+            if (found != expected)
+                std::printf("  %s: size %zu, length %zu, found %zu, expected %zu\n", Scanner::KernelName(kernel), data.size(), length, found, expected);
+            CHECK(found == expected);
+        }
+    }
+
+    std::vector<std::uint8_t> small = { 1, 2, 3 };
+    CHECK(Scanner::Find(small.data(), small.size(), Scanner::Parse("01 02 03 04")) == Scanner::npos);
+    CHECK(Scanner::Find(small.data(), small.size(), Scanner::Parse("?? ??")) == 0);
+}
+
+static std::vector<Scanner::Pattern> MakePatterns(const std::vector<std::uint8_t>& data, size_t count, std::mt19937& rng)
+{
+    std::vector<Scanner::Pattern> patterns;
+    for (size_t i = 0; i < count; ++i) {
+        size_t length = 2 + rng() % 24;
+        if (i % 5 == 4)
+            patterns.push_back(PatternAt(MakeData(length, rng), 0, length, rng)); // Probably absent
+        else
+            patterns.push_back(PatternAt(data, rng() % (data.size() - length), length, rng));
+    }
+    // Patterns that overlap each other and one that matches everywhere
+    patterns.push_back(Scanner::Parse("48 8B"));
+    patterns.push_back(Scanner::Parse("?? 48 8B ?? 89"));
+    patterns.push_back(Scanner::Parse("8B 48 8B"));
+    patterns.push_back(Scanner::Parse("?? ?? ??"));
+    return patterns;
+}
+
+static std::vector<Scanner::PatternView> Views(const std::vector<Scanner::Pattern>& patterns)
+{
+    std::vector<Scanner::PatternView> views;
+    for (const auto& pattern : patterns)
+        views.push_back(pattern.View());
+    return views;
+}
+
+static void Batch(std::mt19937& rng)
+{
+    for (int round = 0; round < 20; ++round) {
+        auto data = MakeData(20000 + rng() % 20000, rng);
+        auto patterns = MakePatterns(data, 40, rng);
+        Scanner::BatchScanner scanner(Views(patterns));
+        CHECK(scanner.Count() == patterns.size());
+
+        auto offsets = scanner.Scan(data.data(), data.size());
+        for (size_t i = 0; i < patterns.size(); ++i)
+            CHECK(offsets[i] == First(BruteForce(data, patterns[i])));
+
+        // Patterns that aren't pending are left alone
+        std::vector<bool> pending(patterns.size());
+        for (size_t i = 0; i < pending.size(); ++i)
+            pending[i] = i % 2 == 0;
+        offsets = scanner.Scan(data.data(), data.size(), pending);
+        for (size_t i = 0; i < patterns.size(); ++i)
+            CHECK(offsets[i] == (pending[i] ? First(BruteForce(data, patterns[i])) : Scanner::npos));
+
+        std::vector<size_t> limits(patterns.size());
+        for (size_t i = 0; i < limits.size(); ++i)
+            limits[i] = i % 4;
+        auto all = scanner.ScanAll(data.data(), data.size(), limits);
+        for (size_t i = 0; i < patterns.size(); ++i)
+            CHECK(all[i] == BruteForce(data, patterns[i], limits[i]));
+
+        // Matches starting at or past end are left for whoever scans the next block
+        size_t end = data.size() / 2;
+        std::fill(limits.begin(), limits.end(), Scanner::npos);
+        all = scanner.ScanAll(data.data(), data.size(), limits, end);
+        for (size_t i = 0; i < patterns.size(); ++i) {
+            auto expected = BruteForce(data, patterns[i]);
+            std::erase_if(expected, [&](size_t offset) { return offset >= end; });
+            CHECK(all[i] == expected);
+        }
+    }
+}
+
+// Sizes the parallel scans split data into, mirrors ParallelScan
+static size_t BlockSize(size_t size, unsigned int workers)
+{
+    return (std::max)(static_cast<size_t>(1024 * 1024), size / (workers * 4));
+}
+
+static void Parallel(std::mt19937& rng)
+{
+    constexpr size_t size = 9 * 1024 * 1024 + 12345;
+    auto data = MakeData(size, rng);
+
+    // A unique marker planted across every block boundary the worker counts below produce, one byte each side
+    // up to entirely inside the overlap, plus one in the last bytes of the data.
+    const std::string marker = "\x5A\xA5\x3C\xC3\x96\x69\x0F\xF0\xE1\x1E";
+    std::vector<size_t> planted;
+    auto plant = [&](size_t offset) {
+        for (auto other : planted) {
+            if (offset < other + marker.size() && other < offset + marker.size())
+                return;
+        }
+        planted.push_back(offset);
+    };
+    plant(size - marker.size());
+    for (unsigned int workers = 2; workers <= 16; ++workers) {
+        size_t blockSize = BlockSize(size, workers);
+        for (size_t boundary = blockSize; boundary < size; boundary += blockSize)
+            plant(boundary - marker.size() + 1 + planted.size() % marker.size());
+    }
+    for (auto offset : planted)
+        std::copy(marker.begin(), marker.end(), data.begin() + offset);
+
+    auto patterns = MakePatterns(data, 30, rng);
+    patterns.push_back(Scanner::Parse("5A A5 3C C3 96 69 0F F0 E1 1E"));
+    patterns.push_back(Scanner::Parse("5A ?? 3C ?? 96 ?? 0F ?? E1"));
+    Scanner::BatchScanner scanner(Views(patterns));
+
+    std::vector<std::vector<size_t>> expected;
+    for (const auto& pattern : patterns)
+        expected.push_back(BruteForce(data, pattern));
+    CHECK(expected[patterns.size() - 2].size() == planted.size());
+
+    std::vector<bool> pending(patterns.size(), true);
+    std::vector<size_t> limits(patterns.size(), Scanner::npos);
+    std::vector<size_t> fewLimits(patterns.size());
+    for (size_t i = 0; i < fewLimits.size(); ++i)
+        fewLimits[i] = i % 3;
+
+    for (unsigned int workers : { 1, 2, 3, 4, 5, 7, 8, 16 }) {
+        auto offsets = Scanner::ParallelScan(scanner, data.data(), data.size(), pending, workers);
+        auto all = Scanner::ParallelScanAll(scanner, data.data(), data.size(), limits, workers);
+        auto few = Scanner::ParallelScanAll(scanner, data.data(), data.size(), fewLimits, workers);
+        for (size_t i = 0; i < patterns.size(); ++i) {
+            CHECK(offsets[i] == First(expected[i]));
+            CHECK(all[i] == expected[i]);
+            CHECK(few[i] == std::vector<size_t>(expected[i].begin(), expected[i].begin() + (std::min)(fewLimits[i], expected[i].size())));
+            if (all[i] != expected[i])
+                std::printf("  %u workers, pattern %zu: %zu matches, expected %zu\n", workers, i, all[i].size(), expected[i].size());
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(0x4F505057);
+    std::printf("Kernel: %s\n", Scanner::KernelName(Scanner::DetectKernel()));
+
+    Parsing();
+    Kernels(rng);
+    Batch(rng);
+    Parallel(rng);
+
+    std::printf("%s\n", failed ? "FAILED" : "All scanner checks passed.");
+    return failed ? 1 : 0;
+}
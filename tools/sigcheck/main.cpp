@@ -0,0 +1,148 @@
+// Runs every signature the fix uses against a game exe on disk, no need to launch the game.
+//   sigcheck <OPPW4.exe> [--workers N]
+// Prints where each signature resolves, how many times it matches and how long it takes to scan for.
+// Exits with 1 if any signature the fix needs at startup wouldn't resolve. Other match counts than expected are reported as warnings,
+// the fix still uses the match they pick unless they're strict.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mappedfile.hpp"
+#include "signatures.hpp"
+
+struct Result
+{
+    size_t matches = 0;
+    uint32_t rva = Pe::npos;    // Of the match the fix would use
+    double scanMs = 0;
+};
+
+// Finds every match in the sections the signature is tagged with, in address order
+static Result Check(const Pe::Image& image, const Memory::Signature& signature)
+{
+    Result result;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& range : image.Ranges(signature.section)) {
+        size_t offset = 0;
+        while (offset < range.size) {
+            auto found = Scanner::Find(range.data + offset, range.size - offset, signature.pattern);
+            if (found == Scanner::npos)
+                break;
+            if (result.matches++ == signature.index)
+                result.rva = range.rva + (uint32_t)(offset + found);
+            offset += found + 1;
+        }
+    }
+    result.scanMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+static const char* Status(const Memory::Signature& signature, const Result& result)
+{
+    if (result.matches == 0)
+        return "missing";
+    if (result.matches > signature.expected)
+        return "ambiguous";
+    if (result.matches < signature.expected)
+        return "too few";
+    return "ok";
+}
+
+static const char* SectionKind(Scanner::Section section)
+{
+    switch (section) {
+    case Scanner::Section::Code: return "code";
+    case Scanner::Section::Data: return "data";
+    default: return "any";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "usage: sigcheck <OPPW4.exe> [--workers N]\n";
+        return 2;
+    }
+
+    unsigned int workers = Scanner::DefaultWorkers();
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--workers") == 0) {
+            workers = (unsigned int)(std::max)(1, atoi(argv[i + 1]));
+        }
+        else {
+            std::cerr << "unknown option " << argv[i] << "\n";
+            return 2;
+        }
+    }
+
+    MappedFile file(argv[1]);
+    if (!file) {
+        std::cerr << "Failed to open " << argv[1] << "\n";
+        return 1;
+    }
+
+    Pe::Image image(file.Data(), file.Size(), Pe::Layout::File);
+    if (!image.Valid()) {
+        std::cerr << argv[1] << ": " << image.Error() << "\n";
+        return 1;
+    }
+
+    std::printf("%s: machine %04x, timestamp %08x, SizeOfImage %x, %zu MB, %s scan kernel\n", argv[1], image.Machine(), image.Timestamp(),
+        image.SizeOfImage(), file.Size() / (1024 * 1024), Scanner::KernelName(Scanner::DetectKernel()));
+    for (const auto& section : image.Sections()) {
+        std::printf("  %-8s rva %08x size %08x raw %08x+%08x %s\n", section.name.c_str(), section.rva, section.virtualSize,
+            section.rawOffset, section.rawSize, section.Executable() ? "code" : section.InitializedData() ? "data" : "");
+    }
+    std::printf("\n%-48s %-4s %-8s %10s %7s %6s %-9s %9s\n", "Signature", "Kind", "Section", "RVA", "Matches", "Expect", "Status", "Time");
+
+    int failed = 0;
+    int warnings = 0;
+    std::vector<uint32_t> expectedRvas;
+    auto print = [&](const Memory::Signature* signature, bool bDeferred) {
+        auto result = Check(image, *signature);
+        const auto* section = result.rva != Pe::npos ? image.SectionAt(result.rva) : nullptr;
+        auto status = Status(*signature, result);
+
+        char rva[16] = "-";
+        if (result.rva != Pe::npos)
+            snprintf(rva, sizeof(rva), "%x", result.rva);
+        char expect[16];
+        snprintf(expect, sizeof(expect), signature->expected > 1 ? "%zu#%zu" : "%zu", signature->expected, signature->index);
+        std::printf("%-48s %-4s %-8s %10s %7zu %6s %-9s %7.3fms%s\n", signature->name, SectionKind(signature->section), section ? section->name.c_str() : "-",
+            rva, result.matches, expect, status, result.scanMs, bDeferred ? " (deferred)" : "");
+
+        // Same rule as Memory::Pick
+        auto used = signature->bStrict && strcmp(status, "ok") != 0 ? Pe::npos : result.rva;
+        if (strcmp(status, "ok") != 0 && !bDeferred)
+            ++(used == Pe::npos ? failed : warnings);
+        return used;
+    };
+
+    for (auto signature : Signatures)
+        expectedRvas.push_back(print(signature, false));
+    for (auto signature : DeferredSignatures)
+        print(signature, true);
+
+    // Same batched scan the fix runs at startup, for comparison
+    auto start = std::chrono::steady_clock::now();
+    Memory::PatternScan(image, Signatures, workers);
+    double batchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // The batched scan should settle on exactly the matches found one by one above
+    for (size_t i = 0; i < Signatures.size(); ++i) {
+        auto rva = Signatures[i]->address ? image.RvaOf(Signatures[i]->address) : Pe::npos;
+        if (rva != expectedRvas[i]) {
+            std::printf("%s: batched scan resolved to %x, expected %x\n", Signatures[i]->name, rva, expectedRvas[i]);
+            ++failed;
+        }
+    }
+
+    std::printf("\n%zu signature(s), %d failed, %d warning(s). Batched scan with %u worker(s) took %.3fms.\n",
+        Signatures.size() + DeferredSignatures.size(), failed, warnings, workers, batchMs);
+    return failed ? 1 : 0;
+}
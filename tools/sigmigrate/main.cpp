@@ -0,0 +1,765 @@
+// Moves every signature the fix uses to a new game build, for when an update breaks them.
+//   sigmigrate <old.exe> <new.exe> [--rvas <file>] [--workers N]
+// Each signature is resolved in the old exe to find its site. --rvas adds or overrides sites, one "<name>=<hex rva>" per line,
+// for hooks whose signatures were already broken in the old exe. Hooks are placed at an offset from their signature's match,
+// so as long as the instructions in between didn't change those offsets carry over.
+// Sites are found in the new exe by hashing short runs of bytes around each one that don't hold addresses, looking them
+// all up in one rolling hash pass, and letting every place they land vote for where the site moved to. The best voted
+// candidates are compared instruction by instruction, and a new wildcard signature is cut at the winner and grown until it's unique.
+// Exits with 1 if any site couldn't be moved.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mappedfile.hpp"
+#include "signatures.hpp"
+
+// Just enough of an x86-64 decoder to know where each instruction's fields are, so addresses can be told apart from opcodes
+namespace X86
+{
+    struct Insn
+    {
+        uint8_t length = 0;         // 0 if the bytes don't decode
+        uint8_t opcodeEnd = 0;      // Prefixes, REX / VEX and the opcode come before this
+        uint8_t modrmEnd = 0;       // ModRM and SIB, if any, come before this
+        uint8_t dispEnd = 0;
+        uint8_t immEnd = 0;
+        bool bAddress = false;      // The displacement or immediate is RIP-relative, a branch target or an absolute address
+        bool bAddressInImm = false;
+    };
+
+    inline Insn Decode(const std::uint8_t* code, size_t size)
+    {
+        size_t i = 0;
+        bool bOperand16 = false;
+        bool bRexW = false;
+        while (i < size && i < 14) {
+            auto b = code[i];
+            if (b == 0x66)
+                bOperand16 = true;
+            else if (b != 0x67 && b != 0xF0 && b != 0xF2 && b != 0xF3 && b != 0x2E && b != 0x36 && b != 0x3E && b != 0x26 && b != 0x64 && b != 0x65)
+                break;
+            ++i;
+        }
+        if (i < size && (code[i] & 0xF0) == 0x40)
+            bRexW = (code[i++] & 0x08) != 0;
+        if (i >= size)
+            return {};
+
+        Insn insn;
+        size_t z = bOperand16 ? 2 : 4;
+        size_t imm = 0;
+        bool bModrm = false;
+        bool bGroup3 = false;   // test r/m, imm shares its opcode with not / neg / mul / div
+        auto op = code[i++];
+        if (op == 0xC4 || op == 0xC5 || op == 0x62) {
+            // VEX / EVEX, the payload picks the opcode map
+            size_t payload = op == 0xC5 ? 1 : op == 0xC4 ? 2 : 3;
+            if (i + payload >= size)
+                return {};
+            int map = op == 0xC5 ? 1 : code[i] & (op == 0x62 ? 0x07 : 0x1F);
+            i += payload;
+            op = code[i++];
+            if (map < 1 || map > 3)
+                return {};
+            bModrm = !(map == 1 && op == 0x77);
+            imm = map == 3 || (map == 1 && ((op >= 0x70 && op <= 0x73) || op == 0xC2 || (op >= 0xC4 && op <= 0xC6))) ? 1 : 0;
+        }
+        else if (op == 0x0F) {
+            if (i >= size)
+                return {};
+            op = code[i++];
+            if (op == 0x38 || op == 0x3A) {
+                if (i >= size)
+                    return {};
+                imm = op == 0x3A ? 1 : 0;
+                ++i;
+                bModrm = true;
+            }
+            else if ((op >= 0x80 && op <= 0x8F)) {
+                imm = 4;
+                insn.bAddress = insn.bAddressInImm = true;
+            }
+            else {
+                bool bNoModrm = op == 0x05 || op == 0x06 || op == 0x07 || op == 0x08 || op == 0x09 || op == 0x0B || op == 0x0E || (op >= 0x30 && op <= 0x37) ||
+                    op == 0x77 || op == 0xA0 || op == 0xA1 || op == 0xA2 || op == 0xA8 || op == 0xA9 || op == 0xAA || (op >= 0xC8 && op <= 0xCF);
+                bModrm = !bNoModrm;
+                imm = (op >= 0x70 && op <= 0x73) || op == 0x0F || op == 0xA4 || op == 0xAC || op == 0xBA || op == 0xC2 || (op >= 0xC4 && op <= 0xC6) ? 1 : 0;
+            }
+        }
+        else {
+            switch (op) {
+            case 0x06: case 0x07: case 0x0E: case 0x16: case 0x17: case 0x1E: case 0x1F: case 0x27: case 0x2F: case 0x37: case 0x3F:
+            case 0x60: case 0x61: case 0x82: case 0x9A: case 0xCE: case 0xD4: case 0xD5: case 0xD6: case 0xEA:
+                return {}; // Not valid in 64-bit mode
+            }
+            if (op < 0x40) {
+                bModrm = (op & 7) < 4;
+                imm = (op & 7) == 4 ? 1 : (op & 7) == 5 ? z : 0;
+            }
+            else if (op == 0xF6 || op == 0xF7) {
+                bModrm = true;
+                bGroup3 = true;
+            }
+            else if (op == 0x63 || op == 0x69 || op == 0x6B || (op >= 0x80 && op <= 0x8F) || op == 0xC0 || op == 0xC1 || op == 0xC6 || op == 0xC7 ||
+                (op >= 0xD0 && op <= 0xD3) || (op >= 0xD8 && op <= 0xDF) || op == 0xFE || op == 0xFF) {
+                bModrm = true;
+                imm = op == 0x69 || op == 0x81 || op == 0xC7 ? z : op == 0x6B || op == 0x80 || op == 0x83 || op == 0xC0 || op == 0xC1 || op == 0xC6 ? 1 : 0;
+            }
+            else if (op == 0x68 || op == 0xA9) {
+                imm = z;
+            }
+            else if (op == 0x6A || op == 0xA8 || (op >= 0xB0 && op <= 0xB7) || op == 0xCD || (op >= 0xE4 && op <= 0xE7)) {
+                imm = 1;
+            }
+            else if ((op >= 0x70 && op <= 0x7F) || (op >= 0xE0 && op <= 0xE3) || op == 0xEB) {
+                imm = 1;
+                insn.bAddress = insn.bAddressInImm = true;
+            }
+            else if (op == 0xE8 || op == 0xE9) {
+                imm = 4;
+                insn.bAddress = insn.bAddressInImm = true;
+            }
+            else if (op >= 0xA0 && op <= 0xA3) {
+                imm = 8; // moffs
+                insn.bAddress = insn.bAddressInImm = true;
+            }
+            else if (op >= 0xB8 && op <= 0xBF) {
+                imm = bRexW ? 8 : z;
+            }
+            else if (op == 0xC2 || op == 0xCA) {
+                imm = 2;
+            }
+            else if (op == 0xC8) {
+                imm = 3;
+            }
+        }
+        insn.opcodeEnd = (uint8_t)i;
+
+        size_t disp = 0;
+        if (bModrm) {
+            if (i >= size)
+                return {};
+            auto modrm = code[i++];
+            auto mod = modrm >> 6;
+            auto rm = modrm & 7;
+            if (bGroup3 && ((modrm >> 3) & 7) < 2)
+                imm = op == 0xF6 ? 1 : z;
+            if (mod != 3) {
+                if (rm == 4) {
+                    if (i >= size)
+                        return {};
+                    if (mod == 0 && (code[i] & 7) == 5)
+                        disp = 4;
+                    ++i;
+                }
+                if (mod == 0 && rm == 5) {
+                    disp = 4;
+                    insn.bAddress = true;
+                }
+                else if (mod == 1) {
+                    disp = 1;
+                }
+                else if (mod == 2) {
+                    disp = 4;
+                }
+            }
+        }
+        insn.modrmEnd = (uint8_t)i;
+        insn.dispEnd = (uint8_t)(i + disp);
+        insn.immEnd = (uint8_t)(i + disp + imm);
+        if (insn.immEnd > size || insn.immEnd > 15)
+            return {};
+        insn.length = insn.immEnd;
+        return insn;
+    }
+
+    // Length of the instruction, treating anything that doesn't decode as a single byte of data
+    inline size_t Step(const Insn& insn) { return insn.length ? insn.length : 1; }
+
+    // Whether byte i of the instruction holds an address that moves between builds
+    inline bool IsAddressByte(const Insn& insn, size_t i)
+    {
+        if (!insn.bAddress)
+            return false;
+        return insn.bAddressInImm ? i >= insn.dispEnd && i < insn.immEnd : i >= insn.modrmEnd && i < insn.dispEnd;
+    }
+}
+
+namespace
+{
+    constexpr size_t AnchorLength = 12;
+    constexpr size_t AnchorsPerSite = 48;
+    constexpr size_t MaxAnchorHits = 8;        // Anchors that land more often than this say nothing about where a site went
+    constexpr size_t Context = 192;            // Bytes either side of a site that anchors are taken from
+    constexpr size_t MaxPatternLength = 64;
+    constexpr double MinScore = 0.6;
+    constexpr size_t DecisiveVotes = 6;        // Distinct anchors agreeing on the same address
+    constexpr uint64_t HashBase = 0x100000001B3ull;
+
+    struct Site
+    {
+        std::string name;
+        const Memory::Signature* signature = nullptr;
+        Scanner::Section section = Scanner::Section::Code;
+        uint32_t oldRva = Pe::npos;
+        size_t patternSize = 16;
+
+        uint32_t newRva = Pe::npos;
+        double score = 0;
+        size_t votes = 0;
+        size_t expected = 1;
+        size_t index = 0;
+        std::string pattern;
+        const char* status = "lost";
+    };
+
+    struct Anchor
+    {
+        uint64_t hash;
+        size_t site;
+        int32_t offset;     // From the site
+        const std::uint8_t* bytes;
+    };
+
+    struct Hit
+    {
+        size_t anchor;
+        uint32_t rva;
+    };
+
+    uint64_t Hash(const std::uint8_t* bytes)
+    {
+        uint64_t hash = 0;
+        for (size_t i = 0; i < AnchorLength; ++i)
+            hash = hash * HashBase + bytes[i];
+        return hash;
+    }
+
+    // The range of an image holding an RVA, clipped to what's backed by the file
+    bool RangeOf(const Pe::Image& image, uint32_t rva, Pe::Range& out)
+    {
+        for (const auto& range : image.Ranges(Scanner::Section::Any)) {
+            if (rva >= range.rva && rva - range.rva < range.size) {
+                out = range;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Marks the bytes of [begin, end) that hold addresses, decoding from the start of the function containing them when there is one
+    std::vector<bool> StableBytes(const std::vector<Pe::Function>& functions, const Pe::Range& range, uint32_t begin, uint32_t end, bool bCode)
+    {
+        std::vector<bool> stable(end - begin, true);
+        if (!bCode)
+            return stable;
+
+        auto start = begin;
+        auto function = std::upper_bound(functions.begin(), functions.end(), begin, [](uint32_t rva, const Pe::Function& f) { return rva < f.begin; });
+        if (function != functions.begin() && (--function)->end > begin && function->begin >= range.rva && begin - function->begin < 4096)
+            start = function->begin;
+
+        auto data = range.data - range.rva;
+        auto limit = range.rva + (uint32_t)range.size;
+        for (auto rva = start; rva < end;) {
+            auto insn = X86::Decode(data + rva, limit - rva);
+            for (size_t i = 0; i < insn.length; ++i) {
+                if (rva + i >= begin && rva + i < end && X86::IsAddressByte(insn, i))
+                    stable[rva + i - begin] = false;
+            }
+            rva += (uint32_t)X86::Step(insn);
+        }
+        return stable;
+    }
+
+    // Opcode of every instruction in the first span bytes, without REX since that changes with register allocation
+    std::vector<uint64_t> Opcodes(const std::uint8_t* code, size_t size, size_t span)
+    {
+        std::vector<uint64_t> opcodes;
+        for (size_t i = 0; i < (std::min)(span, size);) {
+            auto insn = X86::Decode(code + i, size - i);
+            uint64_t token = insn.length ? 0 : (uint64_t)code[i] << 8 | 1;
+            for (size_t j = 0; j < insn.opcodeEnd; ++j) {
+                if ((code[i + j] & 0xF0) != 0x40 || j + 1 == insn.opcodeEnd)
+                    token = token * HashBase + code[i + j];
+            }
+            opcodes.push_back(token);
+            i += X86::Step(insn);
+        }
+        return opcodes;
+    }
+
+    // How much of the code at b looks like the code at a, as the share of a's opcodes that appear in the same order at b.
+    // Operands are left out since they're what changes most between builds. Data is compared byte for byte.
+    double Similarity(const std::uint8_t* a, size_t aSize, const std::uint8_t* b, size_t bSize, size_t span, bool bCode)
+    {
+        span = (std::min)({ span, aSize, bSize });
+        if (span == 0)
+            return 0;
+
+        if (!bCode) {
+            size_t same = 0;
+            for (size_t i = 0; i < span; ++i)
+                same += a[i] == b[i];
+            return (double)same / span;
+        }
+
+        // Longest common subsequence, a site is a few dozen instructions at most
+        auto x = Opcodes(a, aSize, span);
+        auto y = Opcodes(b, bSize, span);
+        std::vector<size_t> row(y.size() + 1);
+        for (size_t i = 0; i < x.size(); ++i) {
+            size_t diagonal = 0;
+            for (size_t j = 0; j < y.size(); ++j) {
+                auto above = row[j + 1];
+                row[j + 1] = x[i] == y[j] ? diagonal + 1 : (std::max)(row[j], above);
+                diagonal = above;
+            }
+        }
+        return x.empty() ? 0 : (double)row[y.size()] / x.size();
+    }
+
+    // Counts matches of pattern in the sections of its kind, up to limit, and returns which of them is at rva
+    size_t CountMatches(const Pe::Image& image, Scanner::Section section, const Scanner::PatternView& pattern, uint32_t rva, size_t limit, size_t& position)
+    {
+        size_t matches = 0;
+        position = SIZE_MAX;
+        for (const auto& range : image.Ranges(section)) {
+            for (size_t offset = 0; offset < range.size && matches < limit;) {
+                auto found = Scanner::Find(range.data + offset, range.size - offset, pattern);
+                if (found == Scanner::npos)
+                    break;
+                if (range.rva + offset + found == rva)
+                    position = matches;
+                ++matches;
+                offset += found + 1;
+            }
+        }
+        return matches;
+    }
+
+    std::string Format(const std::vector<std::uint8_t>& bytes, const std::vector<bool>& literal)
+    {
+        std::string text;
+        char hex[4];
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            if (i)
+                text += ' ';
+            snprintf(hex, sizeof(hex), "%02X", bytes[i]);
+            text += literal[i] ? hex : "??";
+        }
+        return text;
+    }
+
+    // Cuts a signature at the site's new address and grows it until it only matches there.
+    // Code keeps prefixes, opcodes and immediates and wildcards operands the way the fix's own signatures do. If that's
+    // never unique the ModRM bytes and plain displacements are kept too. Anything that differs from the old build is always wildcarded.
+    bool Generate(const Pe::Image& oldImage, const Pe::Image& newImage, Site& site)
+    {
+        Pe::Range oldRange, newRange;
+        if (!RangeOf(oldImage, site.oldRva, oldRange) || !RangeOf(newImage, site.newRva, newRange))
+            return false;
+
+        auto a = oldRange.data + (site.oldRva - oldRange.rva);
+        auto aSize = oldRange.size - (site.oldRva - oldRange.rva);
+        auto b = newRange.data + (site.newRva - newRange.rva);
+        auto bSize = (std::min)(newRange.size - (site.newRva - newRange.rva), MaxPatternLength + 15);
+        bool bCode = site.section == Scanner::Section::Code;
+        size_t expectedOld = site.signature ? site.signature->expected : 1;
+        size_t indexOld = site.signature ? site.signature->index : 0;
+
+        for (int level = 0; level < (bCode ? 2 : 1); ++level) {
+            std::vector<std::uint8_t> bytes;
+            std::vector<bool> literal;
+            size_t ai = 0;
+            while (bytes.size() < MaxPatternLength && bytes.size() < bSize) {
+                // One instruction (or 4 bytes of data) at a time
+                size_t length = 4;
+                X86::Insn insn;
+                X86::Insn old;
+                if (bCode) {
+                    insn = X86::Decode(b + bytes.size(), bSize - bytes.size());
+                    old = ai < aSize ? X86::Decode(a + ai, aSize - ai) : X86::Insn{};
+                    length = X86::Step(insn);
+                }
+                length = (std::min)(length, bSize - bytes.size());
+                // Old and new instructions line up as long as nothing was inserted ahead of them
+                bool bAligned = bCode && old.length == insn.length && ai + length <= aSize;
+
+                for (size_t i = 0; i < length; ++i) {
+                    auto value = b[bytes.size()];
+                    bool bKeep = true;
+                    if (bCode) {
+                        if (insn.length && X86::IsAddressByte(insn, i))
+                            bKeep = false;
+                        else if (insn.length && i >= insn.opcodeEnd && i < insn.dispEnd)
+                            bKeep = level > 0;
+                        if (bAligned && a[ai + i] != value)
+                            bKeep = false;
+                    }
+                    else {
+                        bKeep = bytes.size() < aSize && a[bytes.size()] == value;
+                    }
+                    bytes.push_back(value);
+                    literal.push_back(bKeep);
+                }
+                ai += bCode ? X86::Step(old) : length;
+
+                if (bytes.size() < (std::min)(site.patternSize, MaxPatternLength) || std::count(literal.begin(), literal.end(), true) < 4)
+                    continue;
+
+                std::vector<std::uint8_t> mask(literal.size());
+                std::vector<std::uint8_t> masked(bytes.size());
+                for (size_t i = 0; i < bytes.size(); ++i) {
+                    mask[i] = literal[i] ? 0xFF : 0x00;
+                    masked[i] = bytes[i] & mask[i];
+                }
+                Scanner::Pattern pattern{ masked, mask };
+                size_t position = 0;
+                auto matches = CountMatches(newImage, site.section, pattern, site.newRva, (std::max)(expectedOld, indexOld + 1) + 1, position);
+                if (matches == 1 && position == 0) {
+                    site.expected = 1;
+                    site.index = 0;
+                }
+                else if (matches == expectedOld && position == indexOld) {
+                    site.expected = expectedOld;
+                    site.index = indexOld;
+                }
+                else {
+                    continue;
+                }
+                site.pattern = Format(bytes, literal);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const char* SectionName(Scanner::Section section)
+    {
+        switch (section) {
+        case Scanner::Section::Code: return "Code";
+        case Scanner::Section::Data: return "Data";
+        default: return "Any";
+        }
+    }
+
+    // Runs fn(i) for every i below count on a pool of workers
+    template<typename Fn>
+    void Parallel(size_t count, unsigned int workers, Fn fn)
+    {
+        std::atomic<size_t> next = 0;
+        auto worker = [&] {
+            for (size_t i = next++; i < count; i = next++)
+                fn(i);
+        };
+        std::vector<std::thread> threads;
+        for (unsigned int i = 1; i < (std::min)((size_t)workers, count); ++i)
+            threads.emplace_back(worker);
+        worker();
+        for (auto& thread : threads)
+            thread.join();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cerr << "usage: sigmigrate <old.exe> <new.exe> [--rvas <file>] [--workers N]\n";
+        return 2;
+    }
+
+    unsigned int workers = Scanner::DefaultWorkers();
+    const char* rvaFile = nullptr;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--workers") == 0) {
+            workers = (unsigned int)(std::max)(1, atoi(argv[i + 1]));
+        }
+        else if (strcmp(argv[i], "--rvas") == 0) {
+            rvaFile = argv[i + 1];
+        }
+        else {
+            std::cerr << "unknown option " << argv[i] << "\n";
+            return 2;
+        }
+    }
+
+    MappedFile oldFile(argv[1]);
+    MappedFile newFile(argv[2]);
+    for (auto [file, path] : { std::pair{ &oldFile, argv[1] }, std::pair{ &newFile, argv[2] } }) {
+        if (!*file) {
+            std::cerr << "Failed to open " << path << "\n";
+            return 1;
+        }
+    }
+    Pe::Image oldImage(oldFile.Data(), oldFile.Size(), Pe::Layout::File);
+    Pe::Image newImage(newFile.Data(), newFile.Size(), Pe::Layout::File);
+    for (auto [image, path] : { std::pair{ &oldImage, argv[1] }, std::pair{ &newImage, argv[2] } }) {
+        if (!image->Valid()) {
+            std::cerr << path << ": " << image->Error() << "\n";
+            return 1;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+
+    // Sites come from where the signatures resolve in the old build
+    std::vector<Memory::Signature*> all = Signatures;
+    all.insert(all.end(), DeferredSignatures.begin(), DeferredSignatures.end());
+    Memory::PatternScan(oldImage, all, workers);
+
+    std::vector<Site> sites;
+    for (auto signature : all) {
+        Site site;
+        site.name = signature->name;
+        site.signature = signature;
+        site.section = signature->section;
+        site.patternSize = signature->pattern.size();
+        site.oldRva = signature->address ? oldImage.RvaOf(signature->address) : Pe::npos;
+        sites.push_back(site);
+    }
+
+    if (rvaFile) {
+        std::ifstream file(rvaFile);
+        if (!file) {
+            std::cerr << "Failed to open " << rvaFile << "\n";
+            return 1;
+        }
+        for (std::string line; std::getline(file, line);) {
+            auto equals = line.rfind('=');
+            if (line.empty() || line[0] == '#' || equals == std::string::npos)
+                continue;
+            auto name = line.substr(0, equals);
+            auto rva = (uint32_t)strtoul(line.c_str() + equals + 1, nullptr, 16);
+            auto site = std::find_if(sites.begin(), sites.end(), [&](const Site& site) { return site.name == name; });
+            if (site == sites.end()) {
+                const auto* section = oldImage.SectionAt(rva);
+                Site added;
+                added.name = name;
+                added.section = section && section->Executable() ? Scanner::Section::Code : Scanner::Section::Data;
+                sites.push_back(std::move(added));
+                site = sites.end() - 1;
+            }
+            site->oldRva = rva;
+        }
+    }
+    double resolveMs = elapsed();
+
+    // Signatures that still resolve the way they should need nothing new
+    Parallel(sites.size(), workers, [&](size_t i) {
+        auto& site = sites[i];
+        if (!site.signature || site.oldRva == Pe::npos)
+            return;
+        size_t limit = (std::max)(site.signature->expected, site.signature->index + 1) + 1;
+        uint32_t rva = Pe::npos;
+        size_t matches = 0;
+        for (const auto& range : newImage.Ranges(site.section)) {
+            for (size_t offset = 0; offset < range.size && matches < limit;) {
+                auto found = Scanner::Find(range.data + offset, range.size - offset, site.signature->pattern);
+                if (found == Scanner::npos)
+                    break;
+                if (matches++ == site.signature->index)
+                    rva = range.rva + (uint32_t)(offset + found);
+                offset += found + 1;
+            }
+        }
+        if (matches == site.signature->expected && rva != Pe::npos) {
+            site.newRva = rva;
+            site.status = "unchanged";
+            site.pattern = site.signature->pattern.text;
+            site.expected = site.signature->expected;
+            site.index = site.signature->index;
+            site.score = 1;
+        }
+    });
+
+    // Anchors around every site that has to be found again
+    auto functions = oldImage.Functions();
+    std::vector<Anchor> anchors;
+    for (size_t s = 0; s < sites.size(); ++s) {
+        auto& site = sites[s];
+        Pe::Range range;
+        if (site.newRva != Pe::npos || site.oldRva == Pe::npos || !RangeOf(oldImage, site.oldRva, range))
+            continue;
+
+        auto begin = (uint32_t)(std::max)((int64_t)range.rva, (int64_t)site.oldRva - (int64_t)Context);
+        auto end = (uint32_t)(std::min)((uint64_t)range.rva + range.size, (uint64_t)site.oldRva + Context);
+        auto stable = StableBytes(functions, range, begin, end, site.section == Scanner::Section::Code);
+        auto data = range.data - range.rva;
+
+        std::vector<Anchor> candidates;
+        for (auto rva = begin; rva + AnchorLength <= end; ++rva) {
+            auto first = stable.begin() + (rva - begin);
+            if (std::find(first, first + AnchorLength, false) != first + AnchorLength)
+                continue;
+            // Padding and zero fill are everywhere
+            auto bytes = data + rva;
+            std::vector<std::uint8_t> distinct(bytes, bytes + AnchorLength);
+            std::sort(distinct.begin(), distinct.end());
+            if (std::unique(distinct.begin(), distinct.end()) - distinct.begin() < 4)
+                continue;
+            candidates.push_back({ Hash(bytes), s, (int32_t)rva - (int32_t)site.oldRva, bytes });
+        }
+
+        // Closest to the site first
+        std::sort(candidates.begin(), candidates.end(), [](const Anchor& a, const Anchor& b) { return std::abs(a.offset) < std::abs(b.offset); });
+        std::vector<Anchor> chosen;
+        for (const auto& candidate : candidates) {
+            if (chosen.size() >= AnchorsPerSite)
+                break;
+            // Every other byte is plenty, neighbours overlap almost entirely
+            if (std::any_of(chosen.begin(), chosen.end(), [&](const Anchor& a) { return std::abs(a.offset - candidate.offset) < 2; }))
+                continue;
+            chosen.push_back(candidate);
+        }
+        anchors.insert(anchors.end(), chosen.begin(), chosen.end());
+    }
+    std::sort(anchors.begin(), anchors.end(), [](const Anchor& a, const Anchor& b) { return a.hash < b.hash; });
+
+    // Quick reject before the binary search, most positions don't share the top bits of any anchor
+    std::vector<uint64_t> filter(1 << 10);
+    for (const auto& anchor : anchors)
+        filter[anchor.hash >> 54] |= 1ull << ((anchor.hash >> 48) & 63);
+
+    // One rolling hash pass over the new exe, split into blocks that run an anchor's length into the next so no position is missed
+    struct Block
+    {
+        const std::uint8_t* data;
+        size_t size;
+        uint32_t rva;
+    };
+    std::vector<Block> blocks;
+    constexpr size_t BlockSize = 1024 * 1024;
+    for (const auto& range : newImage.Ranges(Scanner::Section::Any)) {
+        for (size_t offset = 0; offset < range.size; offset += BlockSize)
+            blocks.push_back({ range.data + offset, (std::min)(BlockSize + AnchorLength - 1, range.size - offset), range.rva + (uint32_t)offset });
+    }
+
+    uint64_t power = 1;
+    for (size_t i = 1; i < AnchorLength; ++i)
+        power *= HashBase;
+
+    std::vector<std::vector<Hit>> blockHits(blocks.size());
+    if (!anchors.empty()) {
+        Parallel(blocks.size(), workers, [&](size_t b) {
+            const auto& block = blocks[b];
+            if (block.size < AnchorLength)
+                return;
+            auto hash = Hash(block.data);
+            for (size_t i = 0;; ++i) {
+                if ((filter[hash >> 54] >> ((hash >> 48) & 63)) & 1) {
+                    auto first = std::lower_bound(anchors.begin(), anchors.end(), hash, [](const Anchor& a, uint64_t hash) { return a.hash < hash; });
+                    for (auto it = first; it != anchors.end() && it->hash == hash; ++it) {
+                        if (memcmp(block.data + i, it->bytes, AnchorLength) == 0)
+                            blockHits[b].push_back({ (size_t)(it - anchors.begin()), block.rva + (uint32_t)i });
+                    }
+                }
+                if (i + AnchorLength >= block.size)
+                    break;
+                hash = (hash - block.data[i] * power) * HashBase + block.data[i + AnchorLength];
+            }
+        });
+    }
+    double hashMs = elapsed() - resolveMs;
+
+    std::vector<Hit> hits;
+    for (auto& block : blockHits)
+        hits.insert(hits.end(), block.begin(), block.end());
+    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.anchor < b.anchor || (a.anchor == b.anchor && a.rva < b.rva); });
+
+    // Every hit of a distinctive anchor votes for the site being at the same distance from it as before
+    std::vector<std::vector<uint32_t>> votes(sites.size());
+    for (size_t h = 0; h < hits.size();) {
+        size_t next = h;
+        while (next < hits.size() && hits[next].anchor == hits[h].anchor)
+            ++next;
+        const auto& anchor = anchors[hits[h].anchor];
+        if (next - h <= MaxAnchorHits) {
+            for (size_t i = h; i < next; ++i)
+                votes[anchor.site].push_back(hits[i].rva - anchor.offset);
+        }
+        h = next;
+    }
+
+    // The best voted candidates are compared with the old code, then a signature is cut at the winner
+    Parallel(sites.size(), workers, [&](size_t s) {
+        auto& site = sites[s];
+        Pe::Range oldRange;
+        if (site.newRva != Pe::npos || site.oldRva == Pe::npos || !RangeOf(oldImage, site.oldRva, oldRange))
+            return;
+
+        auto& ballots = votes[s];
+        std::sort(ballots.begin(), ballots.end());
+        std::vector<std::pair<size_t, uint32_t>> tally;
+        for (size_t i = 0; i < ballots.size();) {
+            size_t next = i;
+            while (next < ballots.size() && ballots[next] == ballots[i])
+                ++next;
+            tally.push_back({ next - i, ballots[i] });
+            i = next;
+        }
+        std::sort(tally.begin(), tally.end(), [](const auto& a, const auto& b) { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+        if (tally.size() > 8)
+            tally.resize(8);
+
+        auto a = oldRange.data + (site.oldRva - oldRange.rva);
+        auto aSize = oldRange.size - (site.oldRva - oldRange.rva);
+        bool bCode = site.section == Scanner::Section::Code;
+        for (const auto& [count, rva] : tally) {
+            Pe::Range newRange;
+            if (!RangeOf(newImage, rva, newRange))
+                continue;
+            // Votes decide. A few votes could be chance, so then the code there has to look like the site as well.
+            auto score = Similarity(a, aSize, newRange.data + (rva - newRange.rva), newRange.size - (rva - newRange.rva), (std::max)(site.patternSize, (size_t)32), bCode);
+            if ((count >= DecisiveVotes || score >= MinScore) && (count > site.votes || (count == site.votes && score > site.score))) {
+                site.score = score;
+                site.votes = count;
+                site.newRva = rva;
+            }
+        }
+
+        if (site.newRva != Pe::npos)
+            site.status = Generate(oldImage, newImage, site) ? "moved" : "not unique";
+    });
+    double matchMs = elapsed() - resolveMs - hashMs;
+
+    std::printf("%s -> %s, %zu anchor(s), %zu hit(s), %u worker(s)\n\n", argv[1], argv[2], anchors.size(), hits.size(), workers);
+    std::printf("%-48s %-4s %10s %10s %6s %5s %-10s\n", "Site", "Kind", "Old RVA", "New RVA", "Score", "Votes", "Status");
+    int failed = 0;
+    for (const auto& site : sites) {
+        char oldRva[16] = "-";
+        char newRva[16] = "-";
+        if (site.oldRva != Pe::npos)
+            snprintf(oldRva, sizeof(oldRva), "%x", site.oldRva);
+        if (site.newRva != Pe::npos)
+            snprintf(newRva, sizeof(newRva), "%x", site.newRva);
+        std::printf("%-48s %-4s %10s %10s %6.2f %5zu %-10s\n", site.name.c_str(), site.section == Scanner::Section::Code ? "code" : "data",
+            oldRva, newRva, site.score, site.votes, site.status);
+        failed += strcmp(site.status, "unchanged") != 0 && strcmp(site.status, "moved") != 0;
+    }
+
+    // Ready to paste over the old ones in signatures.hpp
+    std::printf("\n");
+    for (const auto& site : sites) {
+        if (strcmp(site.status, "moved") != 0)
+            continue;
+        if (site.expected > 1)
+            std::printf("{ \"%s\", Scanner::Sig<\"%s\">, Scanner::Section::%s, %zu, %zu },\n", site.name.c_str(), site.pattern.c_str(), SectionName(site.section), site.expected, site.index);
+        else
+            std::printf("{ \"%s\", Scanner::Sig<\"%s\">, Scanner::Section::%s },\n", site.name.c_str(), site.pattern.c_str(), SectionName(site.section));
+    }
+
+    std::printf("\n%zu site(s), %d failed. Resolve %.1fms, hash %.1fms, match %.1fms.\n", sites.size(), failed, resolveMs, hashMs, matchMs);
+    return failed ? 1 : 0;
+}
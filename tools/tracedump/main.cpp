@@ -0,0 +1,194 @@
+// Converts an OPPW4Fix .trace capture to CSV or Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+//   tracedump <capture.trace> [--csv out.csv] [--json out.json]
+// With no output given, prints a summary of the capture.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "traceformat.hpp"
+
+struct Capture
+{
+    TraceFormat::FileHeader header{};
+    std::vector<std::string> hooks;
+    std::vector<uint64_t> timestamps;
+    std::vector<TraceFormat::HookSample> samples; // frameCount x hookCount
+};
+
+static bool Load(const char* path, Capture& capture)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << path << "\n";
+        return false;
+    }
+
+    auto& header = capture.header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || memcmp(header.magic, TraceFormat::Magic, sizeof(header.magic)) != 0) {
+        std::cerr << path << " is not a trace capture\n";
+        return false;
+    }
+    if (header.version != TraceFormat::Version) {
+        std::cerr << path << " is trace version " << header.version << ", expected " << TraceFormat::Version << "\n";
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.hookCount; ++i) {
+        uint16_t length = 0;
+        file.read(reinterpret_cast<char*>(&length), sizeof(length));
+        std::string name(length, '\0');
+        file.read(name.data(), length);
+        capture.hooks.push_back(std::move(name));
+    }
+
+    capture.timestamps.resize(header.frameCount);
+    capture.samples.resize((size_t)header.frameCount * header.hookCount);
+    for (uint32_t frame = 0; frame < header.frameCount; ++frame) {
+        TraceFormat::FrameHeader frameHeader{};
+        file.read(reinterpret_cast<char*>(&frameHeader), sizeof(frameHeader));
+        file.read(reinterpret_cast<char*>(&capture.samples[(size_t)frame * header.hookCount]), header.hookCount * sizeof(TraceFormat::HookSample));
+        capture.timestamps[frame] = frameHeader.timestamp;
+    }
+
+    if (!file) {
+        std::cerr << path << " is truncated\n";
+        return false;
+    }
+    return true;
+}
+
+static double TicksToUs(const Capture& capture, uint32_t ticks)
+{
+    return capture.header.ticksPerNs > 0 ? ticks / capture.header.ticksPerNs / 1000.0 : 0.0;
+}
+
+// CSV-escapes a hook name, they contain ':' and spaces but never quotes
+static std::string Quoted(const std::string& text)
+{
+    return "\"" + text + "\"";
+}
+
+static bool WriteCsv(const Capture& capture, const char* path)
+{
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to create " << path << "\n";
+        return false;
+    }
+
+    out << "frame,time_ms,frametime_ms";
+    for (const auto& hook : capture.hooks)
+        out << "," << Quoted(hook + " calls") << "," << Quoted(hook + " us");
+    out << "\n";
+
+    char number[32];
+    for (size_t frame = 0; frame < capture.timestamps.size(); ++frame) {
+        double frametime = frame > 0 ? (capture.timestamps[frame] - capture.timestamps[frame - 1]) / 1e6 : 0.0;
+        snprintf(number, sizeof(number), "%.3f,%.3f", capture.timestamps[frame] / 1e6, frametime);
+        out << frame << "," << number;
+        for (size_t hook = 0; hook < capture.hooks.size(); ++hook) {
+            const auto& sample = capture.samples[frame * capture.hooks.size() + hook];
+            snprintf(number, sizeof(number), "%.2f", TicksToUs(capture, sample.ticks));
+            out << "," << sample.calls << "," << number;
+        }
+        out << "\n";
+    }
+    return out.good();
+}
+
+// Each frame becomes a complete event, hook activity becomes counter tracks
+static bool WriteJson(const Capture& capture, const char* path)
+{
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to create " << path << "\n";
+        return false;
+    }
+
+    char event[512];
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"OPPW4Fix\"}}";
+    for (size_t frame = 1; frame < capture.timestamps.size(); ++frame) {
+        double start = capture.timestamps[frame - 1] / 1e3;
+        double duration = (capture.timestamps[frame] - capture.timestamps[frame - 1]) / 1e3;
+        snprintf(event, sizeof(event), ",\n{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%zu}}", start, duration, frame);
+        out << event;
+
+        for (size_t hook = 0; hook < capture.hooks.size(); ++hook) {
+            const auto& sample = capture.samples[frame * capture.hooks.size() + hook];
+            snprintf(event, sizeof(event), ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"calls\":%u,\"us\":%.2f}}",
+                capture.hooks[hook].c_str(), start, sample.calls, TicksToUs(capture, sample.ticks));
+            out << event;
+        }
+    }
+    out << "\n]}\n";
+    return out.good();
+}
+
+static void PrintSummary(const Capture& capture)
+{
+    std::printf("%u frames, %u hooks, TSC %.3f ticks/ns\n", capture.header.frameCount, capture.header.hookCount, capture.header.ticksPerNs);
+    if (capture.timestamps.size() < 2)
+        return;
+
+    std::vector<double> frametimes;
+    for (size_t frame = 1; frame < capture.timestamps.size(); ++frame)
+        frametimes.push_back((capture.timestamps[frame] - capture.timestamps[frame - 1]) / 1e6);
+    std::sort(frametimes.begin(), frametimes.end());
+
+    double total = 0;
+    for (auto frametime : frametimes)
+        total += frametime;
+    std::printf("frametime: mean %.3fms, median %.3fms, p99 %.3fms, max %.3fms\n", total / frametimes.size(),
+        frametimes[frametimes.size() / 2], frametimes[std::min(frametimes.size() - 1, frametimes.size() * 99 / 100)], frametimes.back());
+
+    for (size_t hook = 0; hook < capture.hooks.size(); ++hook) {
+        uint64_t calls = 0;
+        double us = 0;
+        for (size_t frame = 0; frame < capture.timestamps.size(); ++frame) {
+            const auto& sample = capture.samples[frame * capture.hooks.size() + hook];
+            calls += sample.calls;
+            us += TicksToUs(capture, sample.ticks);
+        }
+        std::printf("  %-48s %8.1f calls/frame %10.2f us/frame\n", capture.hooks[hook].c_str(),
+            (double)calls / capture.timestamps.size(), us / capture.timestamps.size());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "usage: tracedump <capture.trace> [--csv out.csv] [--json out.json]\n";
+        return 2;
+    }
+
+    Capture capture;
+    if (!Load(argv[1], capture))
+        return 1;
+
+    bool wrote = false;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            if (!WriteCsv(capture, argv[i + 1]))
+                return 1;
+        }
+        else if (strcmp(argv[i], "--json") == 0) {
+            if (!WriteJson(capture, argv[i + 1]))
+                return 1;
+        }
+        else {
+            std::cerr << "unknown option " << argv[i] << "\n";
+            return 2;
+        }
+        wrote = true;
+    }
+
+    if (!wrote)
+        PrintSummary(capture);
+    return 0;
+}